@@ -5,6 +5,10 @@
 #include <sys/sysinfo.h>
 #include <string.h>
 #include <time.h>
+#include <net/if.h>
+#include <dirent.h>
+#include "proc_file.h"
+#include "trace_helpers.h"
 
 static time_t last_cpu_time = 0;
 static unsigned long last_process_cpu_time = 0;
@@ -13,72 +17,261 @@ void set_last_time() {
     last_cpu_time = time(NULL);
 }
 
+// 常驻打开的 /proc 文件，每个周期用 pread 重新读取
+static struct proc_file loadavg_file = PROC_FILE_INIT;
+static struct proc_file meminfo_file = PROC_FILE_INIT;
+static struct proc_file softirqs_file = PROC_FILE_INIT;
+static struct proc_file interrupts_file = PROC_FILE_INIT;
+static struct proc_file stat_file = PROC_FILE_INIT;
+static struct proc_file diskstats_file = PROC_FILE_INIT;
+static struct proc_file snmp_file = PROC_FILE_INIT;
+static struct proc_file netstat_file = PROC_FILE_INIT;
+static struct proc_file somaxconn_file = PROC_FILE_INIT;
+static struct proc_file pid_status_file = PROC_FILE_INIT;
+static struct proc_file pid_stat_file = PROC_FILE_INIT;
+static struct proc_file pid_limits_file = PROC_FILE_INIT;
+static pid_t pid_status_pid, pid_stat_pid, pid_limits_pid;
+
+// 首次使用时打开，读取失败（如进程已退出）时关闭，下次重新打开
+static const char *proc_read(struct proc_file *f, const char *path) {
+    const char *buf;
+
+    if (!proc_file__is_open(f) && proc_file__open(f, path)) {
+        perror(path);
+        return NULL;
+    }
+    buf = proc_file__read(f);
+    if (!buf) {
+        perror(path);
+        proc_file__close(f);
+    }
+    return buf;
+}
+
+// 进程级文件按 pid 缓存，pid 变化时重新打开
+static const char *proc_read_pid(struct proc_file *f, pid_t *opened, pid_t pid, const char *name) {
+    char path[64];
+
+    if (*opened != pid)
+        proc_file__close(f);
+    *opened = pid;
+    snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+    return proc_read(f, path);
+}
+
 // 打印系统平均负载
 void print_loadavg() {
-    FILE *f = fopen("/proc/loadavg", "r");
+    const char *buf = proc_read(&loadavg_file, "/proc/loadavg");
     time_t t;
 	struct tm *tm;
     char ts[16];
-    char buf[256];
-    int n;
     time(&t);
 	tm = localtime(&t);
 	strftime(ts, sizeof(ts), "%H:%M:%S", tm);
     printf("[time] %8s\n",ts);
-	if (f) {
-		memset(buf, 0, sizeof(buf));
-		n = fread(buf, 1, sizeof(buf), f);
-		if (n){
-            printf("\n[loadavg]\n");
-            printf("lavg1 lavg5 lavg15 running/total last_pid\n");
-            printf("%s\n", buf);
-        }
-		fclose(f);
+	if (buf && *buf) {
+        printf("\n[loadavg]\n");
+        printf("lavg1 lavg5 lavg15 running/total last_pid\n");
+        printf("%s\n", buf);
 	}
 }
 
-void print_mem(pid_t pid){
-    printf("\n[mem]\n");
+// /proc/meminfo 中关注的字段，单位 kB
+static const char *meminfo_keys[] = {
+    "MemAvailable:", "Cached:", "Dirty:", "Writeback:", "Slab:", "AnonPages:",
+};
+#define MEMINFO_KEYS (sizeof(meminfo_keys) / sizeof(meminfo_keys[0]))
+
+static unsigned long long meminfo_prev[MEMINFO_KEYS];
+static int meminfo_sampled;
+
+// 一个资源的 PSI：some/full 的 avg10/avg60/avg300 及累计停顿时间（us）
+struct psi {
+    double some[3];
+    double full[3];
+    unsigned long long some_total;
+    unsigned long long full_total;
+};
+
+struct psi_source {
+    struct proc_file file;
+    struct psi prev;
+    struct timespec ts;
+    int sampled;
+    int missing;    // 内核未开启 PSI 或 cgroup 不是 v2，不再重试
+};
+
+static const char *psi_names[] = { "cpu", "memory", "io" };
+#define PSI_RESOURCES 3
+
+static struct psi_source system_psi[PSI_RESOURCES] = {
+    { .file = PROC_FILE_INIT }, { .file = PROC_FILE_INIT }, { .file = PROC_FILE_INIT },
+};
+static struct psi_source cgroup_psi[PSI_RESOURCES] = {
+    { .file = PROC_FILE_INIT }, { .file = PROC_FILE_INIT }, { .file = PROC_FILE_INIT },
+};
+static pid_t cgroup_psi_pid;
+static char cgroup_path[256];
+
+static void parse_psi_line(const char *p, double *avg, unsigned long long *total) {
+    const char *keys[] = { "avg10=", "avg60=", "avg300=" };
+
+    for (int i = 0; i < 3; i++) {
+        if (!(p = strstr(p, keys[i])))
+            return;
+        p += strlen(keys[i]);
+        avg[i] = proc_scan_double(&p);
+    }
+    if ((p = strstr(p, "total="))) {
+        p += strlen("total=");
+        *total = proc_scan_ull(&p);
+    }
+}
 
-    // 复用 FILE 指针和 buffer
-    FILE *file = fopen("/proc/meminfo", "r");
-    if (!file) {
-        perror("can not open /proc/meminfo");
+static int read_psi(struct psi_source *src, const char *path, struct psi *psi) {
+    const char *p;
+
+    if (src->missing)
+        return -1;
+    if (!proc_file__is_open(&src->file) && proc_file__open(&src->file, path)) {
+        src->missing = 1;
+        return -1;
+    }
+    p = proc_file__read(&src->file);
+    if (!p) {
+        proc_file__close(&src->file);
+        return -1;
+    }
+    memset(psi, 0, sizeof(*psi));
+    do {
+        if (!strncmp(p, "some", 4))
+            parse_psi_line(p, psi->some, &psi->some_total);
+        else if (!strncmp(p, "full", 4))
+            parse_psi_line(p, psi->full, &psi->full_total);
+    } while (proc_next_line(&p));
+    return 0;
+}
+
+// 打印一行 PSI，STALL 为本周期内每秒停顿的毫秒数
+static void print_psi(const char *scope, const char *name, struct psi_source *src, const char *path) {
+    struct psi psi;
+    struct timespec now;
+    double elapsed, some_stall = 0, full_stall = 0;
+
+    if (read_psi(src, path, &psi))
         return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - src->ts.tv_sec) + (now.tv_nsec - src->ts.tv_nsec) / 1e9;
+    if (src->sampled && elapsed > 0) {
+        some_stall = (psi.some_total - src->prev.some_total) / 1000.0 / elapsed;
+        full_stall = (psi.full_total - src->prev.full_total) / 1000.0 / elapsed;
     }
+    printf("%-8s %-7s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %10.1f %10.1f\n", scope, name,
+           psi.some[0], psi.some[1], psi.some[2], psi.full[0], psi.full[1], psi.full[2],
+           some_stall, full_stall);
+    src->prev = psi;
+    src->ts = now;
+    src->sampled = 1;
+}
 
-    char buffer[256];
-    long memory = -1;
+// 目标进程所在的 cgroup v2 目录，兼容 hybrid 模式下挂载在 unified 的情况
+static int find_cgroup_path(pid_t pid, char *buf, size_t size) {
+    char path[512];
+    const char *p, *end;
+    struct proc_file f = PROC_FILE_INIT;
+    int ret = -1;
 
-    // 读取总内存信息
-    while (fgets(buffer, sizeof(buffer), file)) {
-        if (sscanf(buffer, "MemTotal: %ld kB", &memory) == 1) {
-            memory *= 1024;  // 转换为字节
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", pid);
+    if (proc_file__open(&f, path))
+        return -1;
+    p = proc_file__read(&f);
+    while (p) {
+        if (!strncmp(p, "0::", 3)) {
+            p += 3;
+            end = p + strcspn(p, "\n");
+            snprintf(buf, size, "/sys/fs/cgroup%.*s", (int)(end - p), p);
+            snprintf(path, sizeof(path), "%s/cgroup.procs", buf);
+            if (access(path, F_OK))
+                snprintf(buf, size, "/sys/fs/cgroup/unified%.*s", (int)(end - p), p);
+            ret = 0;
             break;
         }
+        if (!proc_next_line(&p))
+            break;
     }
-    fclose(file);
-    printf("total mem: %ld bytes (%.2f GB)\n", memory, memory / (1024.0 * 1024 * 1024));
+    proc_file__close(&f);
+    return ret;
+}
 
-    // 如果指定了 PID，读取进程内存信息
-    if (pid != 0) {
-        snprintf(buffer, sizeof(buffer), "/proc/%d/status", pid);
-        file = fopen(buffer, "r");
-        if (!file) {
-            perror("can not open process status file");
-            return;
+static void print_pressure(pid_t pid) {
+    char path[512];
+
+    printf("\n[pressure]\n");
+    printf("%-8s %-7s %7s %7s %7s %7s %7s %7s %10s %10s\n", "SCOPE", "RES",
+           "SOME10", "SOME60", "SOME300", "FULL10", "FULL60", "FULL300",
+           "SOME_ms/s", "FULL_ms/s");
+    for (int i = 0; i < PSI_RESOURCES; i++) {
+        snprintf(path, sizeof(path), "/proc/pressure/%s", psi_names[i]);
+        print_psi("system", psi_names[i], &system_psi[i], path);
+    }
+
+    if (pid == 0)
+        return;
+    if (cgroup_psi_pid != pid) {
+        for (int i = 0; i < PSI_RESOURCES; i++) {
+            proc_file__close(&cgroup_psi[i].file);
+            memset(&cgroup_psi[i], 0, sizeof(cgroup_psi[i]));
+            cgroup_psi[i].file.fd = -1;
         }
+        cgroup_psi_pid = pid;
+        if (find_cgroup_path(pid, cgroup_path, sizeof(cgroup_path)))
+            cgroup_path[0] = '\0';
+    }
+    if (!cgroup_path[0])
+        return;
+    for (int i = 0; i < PSI_RESOURCES; i++) {
+        snprintf(path, sizeof(path), "%s/%s.pressure", cgroup_path, psi_names[i]);
+        print_psi("cgroup", psi_names[i], &cgroup_psi[i], path);
+    }
+}
 
-        // 读取进程内存使用
-        while (fgets(buffer, sizeof(buffer), file)) {
-            if (sscanf(buffer, "VmRSS: %ld kB", &memory) == 1) {
-                memory *= 1024;  // 转换为字节
-                break;
-            }
+void print_mem(pid_t pid){
+    printf("\n[mem]\n");
+
+    const char *buf = proc_read(&meminfo_file, "/proc/meminfo");
+    unsigned long long kb;
+    long memory = -1;
+
+    // 读取总内存信息
+    if (!buf)
+        return;
+    if (proc_find_ull(buf, "MemTotal:", &kb))
+        memory = kb * 1024;  // 转换为字节
+    printf("total mem: %ld bytes (%.2f GB)\n", memory, memory / (1024.0 * 1024 * 1024));
+
+    // 各项内存及与上个周期相比的变化
+    printf("%-14s %10s %10s\n", "FIELD", "MB", "DELTA_MB");
+    for (size_t i = 0; i < MEMINFO_KEYS; i++) {
+        kb = 0;
+        if (!proc_find_ull(buf, meminfo_keys[i], &kb))
+            continue;
+        printf("%-14.*s %10.1f %+10.1f\n", (int)strlen(meminfo_keys[i]) - 1, meminfo_keys[i],
+               kb / 1024.0, meminfo_sampled ? ((double)kb - meminfo_prev[i]) / 1024.0 : 0);
+        meminfo_prev[i] = kb;
+    }
+    meminfo_sampled = 1;
+
+    // 如果指定了 PID，读取进程内存使用
+    if (pid != 0) {
+        buf = proc_read_pid(&pid_status_file, &pid_status_pid, pid, "status");
+        if (buf) {
+            memory = -1;
+            if (proc_find_ull(buf, "VmRSS:", &kb))
+                memory = kb * 1024;  // 转换为字节
+            printf("pid %d used mem: %ld bytes (%.2f MB)\n", pid, memory, memory / (1024.0 * 1024));
         }
-        fclose(file);
-        printf("pid %d used mem: %ld bytes (%.2f MB)\n", pid, memory, memory / (1024.0 * 1024));
     }
+    print_pressure(pid);
 }
 
 // 打印文件句柄限制
@@ -91,22 +284,872 @@ void print_file_handle_limit() {
     }
 }
 
-// 打印软中断
+// /proc/softirqs、/proc/interrupts 的一次采样，counts 按 行*ncpus+cpu 存放
+struct irq_table {
+    int ncpus;
+    int nlines;
+    int cap;
+    char (*names)[32];
+    char (*descs)[64];
+    unsigned long long *counts;
+    struct timespec ts;
+};
+
+static struct irq_table softirq_samples[2];
+static struct irq_table irq_samples[2];
+static int softirq_cur, irq_cur;
+
+#define IRQ_ROWS 20
+
+static void irq_table_free(struct irq_table *t) {
+    free(t->names);
+    free(t->descs);
+    free(t->counts);
+    memset(t, 0, sizeof(*t));
+}
+
+static int irq_table_grow(struct irq_table *t) {
+    int cap = t->cap ? t->cap * 2 : 64;
+    void *names = realloc(t->names, cap * sizeof(*t->names));
+    if (names)
+        t->names = names;
+    void *descs = realloc(t->descs, cap * sizeof(*t->descs));
+    if (descs)
+        t->descs = descs;
+    void *counts = realloc(t->counts, (size_t)cap * t->ncpus * sizeof(*t->counts));
+    if (counts)
+        t->counts = counts;
+    if (!names || !descs || !counts)
+        return -1;
+    t->cap = cap;
+    return 0;
+}
+
+// 读取 /proc/softirqs 或 /proc/interrupts：首行为 CPU 列，其后每行为 名称: 各CPU计数 [描述]
+static int read_irq_table(struct proc_file *f, const char *path, struct irq_table *t) {
+    const char *buf = proc_read(f, path), *p, *end;
+    int ncpus = 0;
+
+    if (!buf)
+        return -1;
+    end = strchr(buf, '\n');
+    if (!end)
+        return -1;
+    for (p = buf; (p = strstr(p, "CPU")) && p < end; p += 3)
+        ncpus++;
+    if (ncpus != t->ncpus)
+        irq_table_free(t);
+    t->ncpus = ncpus;
+    t->nlines = 0;
+
+    p = buf;
+    while (proc_next_line(&p)) {
+        if (t->nlines == t->cap && irq_table_grow(t))
+            return -1;
+
+        p += strspn(p, " ");
+        end = strchr(p, ':');
+        if (!end)
+            continue;
+        snprintf(t->names[t->nlines], sizeof(t->names[0]), "%.*s", (int)(end - p), p);
+
+        // ERR/MIS 等行列数少于 CPU 数，不足的补 0
+        unsigned long long *counts = &t->counts[(size_t)t->nlines * ncpus];
+        p = end + 1;
+        for (int i = 0; i < ncpus; i++)
+            counts[i] = proc_scan_ull(&p);
+        p += strspn(p, " ");
+        snprintf(t->descs[t->nlines], sizeof(t->descs[0]), "%.*s", (int)strcspn(p, "\n"), p);
+        t->nlines++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t->ts);
+    return 0;
+}
+
+static double irq_elapsed(struct irq_table *prev, struct irq_table *cur) {
+    return (cur->ts.tv_sec - prev->ts.tv_sec) + (cur->ts.tv_nsec - prev->ts.tv_nsec) / 1e9;
+}
+
+// cur 中某一行在 prev 中的行号，按名称匹配（中断增删后行号会错位），没有时返回 -1
+static int irq_prev_line(struct irq_table *prev, struct irq_table *cur, int line) {
+    if (prev->ncpus != cur->ncpus)
+        return -1;
+    if (line < prev->nlines && !strcmp(prev->names[line], cur->names[line]))
+        return line;
+    for (int i = 0; i < prev->nlines; i++)
+        if (!strcmp(prev->names[i], cur->names[line]))
+            return i;
+    return -1;
+}
+
+// 两次采样之间某一行在某 CPU 上的增量，pline 为 irq_prev_line 的结果
+static unsigned long long irq_delta(struct irq_table *prev, struct irq_table *cur, int pline, int line, int cpu) {
+    if (pline < 0)
+        return 0;
+    unsigned long long before = prev->counts[(size_t)pline * prev->ncpus + cpu];
+    unsigned long long after = cur->counts[(size_t)line * cur->ncpus + cpu];
+    return after > before ? after - before : 0;
+}
+
+// /proc/stat 中一个 CPU 的累计时间（jiffies），nice 计入 user
+struct cpu_times {
+    unsigned long long user;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long iowait;
+    unsigned long long irq;
+    unsigned long long softirq;
+    unsigned long long steal;
+};
+
+// 下标 0 为汇总行 cpu，i+1 为 cpui
+static struct cpu_times *cpu_samples[2];
+static int cpu_sample_len[2];
+static int cpu_cur;
+
+#define CPU_SATURATED_PCT 90
+
+static int read_cpu_times(struct cpu_times **times, int *len) {
+    const char *p = proc_read(&stat_file, "/proc/stat");
+    unsigned long long nice;
+    int n = 0, cpu;
+
+    if (!p)
+        return -1;
+    do {
+        if (strncmp(p, "cpu", 3))
+            break;
+        p += 3;
+        if (*p == ' ')
+            cpu = 0;
+        else if (*p >= '0' && *p <= '9')
+            cpu = proc_scan_ull(&p) + 1;
+        else
+            continue;
+        if (cpu >= n)
+            n = cpu + 1;
+        if (n > *len) {
+            struct cpu_times *grown = realloc(*times, n * 2 * sizeof(**times));
+            if (!grown)
+                break;
+            memset(grown + *len, 0, (n * 2 - *len) * sizeof(**times));
+            *times = grown;
+            *len = n * 2;
+        }
+        // user nice system idle iowait irq softirq steal
+        struct cpu_times *t = &(*times)[cpu];
+        t->user = proc_scan_ull(&p);
+        nice = proc_scan_ull(&p);
+        t->user += nice;
+        t->system = proc_scan_ull(&p);
+        t->idle = proc_scan_ull(&p);
+        t->iowait = proc_scan_ull(&p);
+        t->irq = proc_scan_ull(&p);
+        t->softirq = proc_scan_ull(&p);
+        t->steal = proc_scan_ull(&p);
+    } while (proc_next_line(&p));
+    return n;
+}
+
+static unsigned long long cpu_delta(unsigned long long before, unsigned long long after) {
+    return after > before ? after - before : 0;
+}
+
+// 打印一个 CPU 两次采样间各类时间占比，忙碌（非 idle/iowait）超过阈值时标记
+static void print_cpu_times(const char *name, struct cpu_times *prev, struct cpu_times *cur) {
+    unsigned long long user = cpu_delta(prev->user, cur->user);
+    unsigned long long system = cpu_delta(prev->system, cur->system);
+    unsigned long long idle = cpu_delta(prev->idle, cur->idle);
+    unsigned long long iowait = cpu_delta(prev->iowait, cur->iowait);
+    unsigned long long irq = cpu_delta(prev->irq, cur->irq);
+    unsigned long long softirq = cpu_delta(prev->softirq, cur->softirq);
+    unsigned long long steal = cpu_delta(prev->steal, cur->steal);
+    unsigned long long total = user + system + idle + iowait + irq + softirq + steal;
+
+    if (!total)
+        return;
+    double busy = 100.0 * (total - idle - iowait) / total;
+    printf("%-6s %6.1f %6.1f %6.1f %6.1f %6.1f %6.1f %6.1f%s\n", name,
+           100.0 * user / total, 100.0 * system / total, 100.0 * iowait / total,
+           100.0 * irq / total, 100.0 * softirq / total, 100.0 * steal / total,
+           100.0 * idle / total, busy >= CPU_SATURATED_PCT ? "  <- saturated" : "");
+}
+
+static void print_cpu_breakdown() {
+    int prev = cpu_cur, cur = !cpu_cur;
+    int n = read_cpu_times(&cpu_samples[cur], &cpu_sample_len[cur]);
+    char name[16];
+
+    if (n <= 0)
+        return;
+    cpu_cur = cur;
+    if (!cpu_samples[prev])
+        return;
+
+    printf("%-6s %6s %6s %6s %6s %6s %6s %6s\n",
+           "CPU", "USR%", "SYS%", "IOW%", "IRQ%", "SIRQ%", "STEAL%", "IDLE%");
+    if (n > cpu_sample_len[prev])
+        n = cpu_sample_len[prev];
+    print_cpu_times("all", &cpu_samples[prev][0], &cpu_samples[cur][0]);
+    for (int i = 1; i < n; i++) {
+        snprintf(name, sizeof(name), "%d", i - 1);
+        print_cpu_times(name, &cpu_samples[prev][i], &cpu_samples[cur][i]);
+    }
+}
+
+// 与 trace_helpers.c 中 partitions 使用的设备号编码一致
+#define MINORBITS 20
+#define MKDEV(ma, mi) (((ma) << MINORBITS) | (mi))
+
+// /proc/diskstats 前 11 个计数：读次数 读合并 读扇区 读耗时ms 写次数 写合并 写扇区 写耗时ms
+// 进行中IO 活跃时间ms 加权时间ms
+enum {
+    DISK_READS, DISK_READ_MERGES, DISK_READ_SECTORS, DISK_READ_MS,
+    DISK_WRITES, DISK_WRITE_MERGES, DISK_WRITE_SECTORS, DISK_WRITE_MS,
+    DISK_IN_FLIGHT, DISK_IO_MS, DISK_WEIGHTED_MS, DISK_FIELDS,
+};
+
+struct disk_sample {
+    unsigned int dev;
+    char name[32];
+    unsigned long long fields[DISK_FIELDS];
+};
+
+struct disk_table {
+    struct disk_sample *disks;
+    int ndisks;
+    int cap;
+    struct timespec ts;
+};
+
+static struct disk_table disk_samples[2];
+static int disk_cur;
+static struct partitions *partitions;
+
+#define DISK_SATURATED_PCT 90
+
+static int read_diskstats(struct disk_table *t) {
+    const char *p = proc_read(&diskstats_file, "/proc/diskstats");
+    unsigned int major, minor;
+    const char *name;
+
+    if (!p)
+        return -1;
+    t->ndisks = 0;
+    do {
+        if (t->ndisks == t->cap) {
+            int cap = t->cap ? t->cap * 2 : 32;
+            struct disk_sample *disks = realloc(t->disks, cap * sizeof(*disks));
+            if (!disks)
+                return -1;
+            t->disks = disks;
+            t->cap = cap;
+        }
+        struct disk_sample *d = &t->disks[t->ndisks];
+        major = proc_scan_ull(&p);
+        minor = proc_scan_ull(&p);
+        p += strspn(p, " ");
+        name = p;
+        proc_skip_fields(&p, 1);
+        if (p == name)
+            continue;
+        d->dev = MKDEV(major, minor);
+        snprintf(d->name, sizeof(d->name), "%.*s", (int)(p - name), name);
+        for (int i = 0; i < DISK_FIELDS; i++)
+            d->fields[i] = proc_scan_ull(&p);
+        t->ndisks++;
+    } while (proc_next_line(&p));
+    clock_gettime(CLOCK_MONOTONIC, &t->ts);
+    return 0;
+}
+
+static struct disk_sample *find_disk(struct disk_table *t, int hint, unsigned int dev) {
+    if (hint < t->ndisks && t->disks[hint].dev == dev)
+        return &t->disks[hint];
+    for (int i = 0; i < t->ndisks; i++)
+        if (t->disks[i].dev == dev)
+            return &t->disks[i];
+    return NULL;
+}
+
+// 设备名优先取 /proc/partitions，新出现的设备重新加载一次
+static const char *dev_name(unsigned int dev, const char *fallback) {
+    const struct partition *part;
+
+    if (!partitions)
+        partitions = partitions__load();
+    part = partitions ? partitions__get_by_dev(partitions, dev) : NULL;
+    if (!part && partitions) {
+        partitions__free(partitions);
+        partitions = partitions__load();
+        part = partitions ? partitions__get_by_dev(partitions, dev) : NULL;
+    }
+    return part ? part->name : fallback;
+}
+
+// 打印每个有 IO 的块设备的 IOPS、吞吐、平均队列长度、await 及 %util
+void print_diskstats() {
+    struct disk_table *prev = &disk_samples[disk_cur];
+    struct disk_table *cur = &disk_samples[!disk_cur];
+    unsigned long long delta[DISK_FIELDS];
+    bool header_printed = false;
+
+    if (read_diskstats(cur))
+        return;
+    disk_cur = !disk_cur;
+    if (!prev->ndisks)
+        return;
+
+    double elapsed_ms = (cur->ts.tv_sec - prev->ts.tv_sec) * 1000.0 +
+                        (cur->ts.tv_nsec - prev->ts.tv_nsec) / 1e6;
+    if (elapsed_ms <= 0)
+        return;
+
+    for (int i = 0; i < cur->ndisks; i++) {
+        struct disk_sample *d = &cur->disks[i], *old = find_disk(prev, i, d->dev);
+        if (!old)
+            continue;
+        for (int f = 0; f < DISK_FIELDS; f++)
+            delta[f] = d->fields[f] > old->fields[f] ? d->fields[f] - old->fields[f] : 0;
+        if (!delta[DISK_READS] && !delta[DISK_WRITES] && !delta[DISK_IO_MS])
+            continue;
+
+        if (!header_printed) {
+            printf("\n[Disk]\n");
+            printf("%-12s %8s %8s %10s %10s %8s %8s %7s %6s\n", "DEVICE", "R/s", "W/s",
+                   "RKB/s", "WKB/s", "R_AWAIT", "W_AWAIT", "AQU-SZ", "UTIL%");
+            header_printed = true;
+        }
+        double util = 100.0 * delta[DISK_IO_MS] / elapsed_ms;
+        util = util > 100 ? 100 : util;
+        // 扇区固定为 512 字节
+        printf("%-12s %8.1f %8.1f %10.1f %10.1f %8.2f %8.2f %7.2f %6.1f%s\n", dev_name(d->dev, d->name),
+               delta[DISK_READS] * 1000.0 / elapsed_ms,
+               delta[DISK_WRITES] * 1000.0 / elapsed_ms,
+               delta[DISK_READ_SECTORS] / 2.0 * 1000.0 / elapsed_ms,
+               delta[DISK_WRITE_SECTORS] / 2.0 * 1000.0 / elapsed_ms,
+               delta[DISK_READS] ? (double)delta[DISK_READ_MS] / delta[DISK_READS] : 0,
+               delta[DISK_WRITES] ? (double)delta[DISK_WRITE_MS] / delta[DISK_WRITES] : 0,
+               delta[DISK_WEIGHTED_MS] / elapsed_ms, util,
+               util >= DISK_SATURATED_PCT ? "  <- saturated" : "");
+    }
+}
+
+// cgroup v2 资源统计文件，常驻打开
+enum {
+    CG_CPU_STAT, CG_MEM_CURRENT, CG_MEM_MAX, CG_MEM_STAT, CG_MEM_EVENTS, CG_IO_STAT, CG_FILES,
+};
+static const char *cg_file_names[CG_FILES] = {
+    "cpu.stat", "memory.current", "memory.max", "memory.stat", "memory.events", "io.stat",
+};
+
+// "key value" 形式的计数，计数器取增量，其余为当前值
+struct cg_counter {
+    int file;
+    const char *key;
+};
+
+enum {
+    CG_USAGE, CG_PERIODS, CG_THROTTLED, CG_THROTTLED_USEC,
+    CG_ANON, CG_FILE, CG_DIRTY, CG_WRITEBACK, CG_MAJFAULT,
+    CG_EV_HIGH, CG_EV_MAX, CG_EV_OOM, CG_EV_OOM_KILL, CG_COUNTERS,
+};
+static const struct cg_counter cg_counters[CG_COUNTERS] = {
+    [CG_USAGE] = { CG_CPU_STAT, "usage_usec " },
+    [CG_PERIODS] = { CG_CPU_STAT, "nr_periods " },
+    [CG_THROTTLED] = { CG_CPU_STAT, "nr_throttled " },
+    [CG_THROTTLED_USEC] = { CG_CPU_STAT, "throttled_usec " },
+    [CG_ANON] = { CG_MEM_STAT, "anon " },
+    [CG_FILE] = { CG_MEM_STAT, "file " },
+    [CG_DIRTY] = { CG_MEM_STAT, "file_dirty " },
+    [CG_WRITEBACK] = { CG_MEM_STAT, "file_writeback " },
+    [CG_MAJFAULT] = { CG_MEM_STAT, "pgmajfault " },
+    [CG_EV_HIGH] = { CG_MEM_EVENTS, "high " },
+    [CG_EV_MAX] = { CG_MEM_EVENTS, "max " },
+    [CG_EV_OOM] = { CG_MEM_EVENTS, "oom " },
+    [CG_EV_OOM_KILL] = { CG_MEM_EVENTS, "oom_kill " },
+};
+
+#define CG_MAX_DEVS 64
+
+struct cg_io {
+    unsigned int dev;
+    unsigned long long rbytes, wbytes, rios, wios;
+};
+
+static struct {
+    char path[256];
+    struct proc_file files[CG_FILES];
+    int missing;                    // 不存在的文件（控制器未启用），按位记录
+    unsigned long long prev[CG_COUNTERS];
+    struct cg_io io[CG_MAX_DEVS];
+    int nr_io;
+    struct timespec ts;
+    int sampled;
+} cg = {
+    .files = {
+        PROC_FILE_INIT, PROC_FILE_INIT, PROC_FILE_INIT,
+        PROC_FILE_INIT, PROC_FILE_INIT, PROC_FILE_INIT,
+    },
+};
+static pid_t cg_pid;
+
+static void cg_reset(const char *path) {
+    for (int i = 0; i < CG_FILES; i++)
+        proc_file__close(&cg.files[i]);
+    snprintf(cg.path, sizeof(cg.path), "%s", path);
+    cg.missing = 0;
+    cg.nr_io = 0;
+    cg.sampled = 0;
+}
+
+static const char *cg_read(int file) {
+    char path[512];
+    const char *buf;
+
+    if (cg.missing & (1 << file))
+        return NULL;
+    if (!proc_file__is_open(&cg.files[file])) {
+        snprintf(path, sizeof(path), "%s/%s", cg.path, cg_file_names[file]);
+        if (proc_file__open(&cg.files[file], path)) {
+            cg.missing |= 1 << file;
+            return NULL;
+        }
+    }
+    buf = proc_file__read(&cg.files[file]);
+    if (!buf)
+        proc_file__close(&cg.files[file]);
+    return buf;
+}
+
+static double cg_delta(unsigned long long *vals, int i) {
+    return cg.sampled && vals[i] > cg.prev[i] ? vals[i] - cg.prev[i] : 0;
+}
+
+static void print_cg_io(const char *p, double elapsed) {
+    struct cg_io io[CG_MAX_DEVS];
+    int n = 0;
+    char name[32];
+
+    if (!p || !*p)
+        return;
+    // 每行为 "maj:min rbytes=.. wbytes=.. rios=.. wios=.. dbytes=.. dios=.."
+    do {
+        if (n == CG_MAX_DEVS)
+            break;
+        struct cg_io *d = &io[n];
+        unsigned int major = proc_scan_ull(&p);
+        if (*p++ != ':')
+            continue;
+        d->dev = MKDEV(major, (unsigned int)proc_scan_ull(&p));
+        const char *end = p + strcspn(p, "\n"), *v;
+        d->rbytes = d->wbytes = d->rios = d->wios = 0;
+        if ((v = strstr(p, "rbytes=")) && v < end) { v += 7; d->rbytes = proc_scan_ull(&v); }
+        if ((v = strstr(p, "wbytes=")) && v < end) { v += 7; d->wbytes = proc_scan_ull(&v); }
+        if ((v = strstr(p, "rios=")) && v < end) { v += 5; d->rios = proc_scan_ull(&v); }
+        if ((v = strstr(p, "wios=")) && v < end) { v += 5; d->wios = proc_scan_ull(&v); }
+        n++;
+    } while (proc_next_line(&p));
+
+    bool header_printed = false;
+    for (int i = 0; i < n && cg.sampled; i++) {
+        struct cg_io *old = NULL;
+        for (int j = 0; j < cg.nr_io; j++)
+            if (cg.io[j].dev == io[i].dev)
+                old = &cg.io[j];
+        if (!old || (io[i].rios == old->rios && io[i].wios == old->wios))
+            continue;
+        if (!header_printed) {
+            printf("%-12s %8s %8s %10s %10s\n", "DEVICE", "R/s", "W/s", "RKB/s", "WKB/s");
+            header_printed = true;
+        }
+        snprintf(name, sizeof(name), "%u:%u", io[i].dev >> MINORBITS, io[i].dev & ((1U << MINORBITS) - 1));
+        printf("%-12s %8.1f %8.1f %10.1f %10.1f\n", dev_name(io[i].dev, name),
+               (io[i].rios - old->rios) / elapsed, (io[i].wios - old->wios) / elapsed,
+               (io[i].rbytes - old->rbytes) / 1024.0 / elapsed,
+               (io[i].wbytes - old->wbytes) / 1024.0 / elapsed);
+    }
+    memcpy(cg.io, io, n * sizeof(io[0]));
+    cg.nr_io = n;
+}
+
+// cgroup v2 的 CPU 限流、内存及 IO 统计；cgroup 为空时使用目标进程所在的 cgroup
+void print_cgroup_stats(pid_t pid, const char *cgroup) {
+    unsigned long long vals[CG_COUNTERS] = {0}, current = 0, max = 0;
+    char path[256];
+    struct timespec now;
+    const char *bufs[CG_FILES], *p;
+
+    if (cgroup) {
+        if (strcmp(cgroup, cg.path))
+            cg_reset(cgroup);
+    } else if (pid != 0) {
+        if (cg_pid != pid) {
+            cg_pid = pid;
+            if (find_cgroup_path(pid, path, sizeof(path)))
+                path[0] = '\0';
+            cg_reset(path);
+        }
+    }
+    if (!cg.path[0])
+        return;
+
+    for (int i = 0; i < CG_FILES; i++)
+        bufs[i] = cg_read(i);
+    // 不是 v2 cgroup 目录（或控制器全未启用）时不输出
+    if (!bufs[CG_CPU_STAT] && !bufs[CG_MEM_STAT] && !bufs[CG_IO_STAT])
+        return;
+    for (int i = 0; i < CG_COUNTERS; i++)
+        if (bufs[cg_counters[i].file])
+            proc_find_ull(bufs[cg_counters[i].file], cg_counters[i].key, &vals[i]);
+    if ((p = bufs[CG_MEM_CURRENT]))
+        current = proc_scan_ull(&p);
+    // memory.max 为 "max" 时不限制
+    if ((p = bufs[CG_MEM_MAX]) && *p >= '0' && *p <= '9')
+        max = proc_scan_ull(&p);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - cg.ts.tv_sec) + (now.tv_nsec - cg.ts.tv_nsec) / 1e9;
+    if (elapsed <= 0)
+        elapsed = 1;
+
+    printf("\n[cgroup] %s\n", cg.path);
+    if (bufs[CG_CPU_STAT]) {
+        double periods = cg_delta(vals, CG_PERIODS), throttled = cg_delta(vals, CG_THROTTLED);
+        printf("%-8s %10s %10s %10s %12s\n", "CPU%", "PERIODS", "THROTTLED", "THR%", "THR_ms/s");
+        printf("%-8.1f %10.0f %10.0f %10.1f %12.1f%s\n",
+               cg_delta(vals, CG_USAGE) / 1e6 / elapsed * 100, periods, throttled,
+               periods ? 100.0 * throttled / periods : 0,
+               cg_delta(vals, CG_THROTTLED_USEC) / 1000.0 / elapsed,
+               throttled ? "  <- throttled" : "");
+    }
+    if (bufs[CG_MEM_STAT]) {
+        char max_buf[16] = "max";
+        if (max)
+            snprintf(max_buf, sizeof(max_buf), "%.0f", max / 1048576.0);
+        printf("%-8s %8s %8s %8s %8s %8s %9s %5s %5s %5s %8s\n", "MEM_MB", "MAX_MB", "ANON_MB",
+               "FILE_MB", "DIRTY_MB", "WB_MB", "MAJFLT/s", "HIGH", "MAX", "OOM", "OOM_KILL");
+        printf("%-8.0f %8s %8.0f %8.0f %8.1f %8.1f %9.1f %5.0f %5.0f %5.0f %8.0f%s\n",
+               current / 1048576.0, max_buf, vals[CG_ANON] / 1048576.0,
+               vals[CG_FILE] / 1048576.0, vals[CG_DIRTY] / 1048576.0,
+               vals[CG_WRITEBACK] / 1048576.0, cg_delta(vals, CG_MAJFAULT) / elapsed,
+               cg_delta(vals, CG_EV_HIGH), cg_delta(vals, CG_EV_MAX),
+               cg_delta(vals, CG_EV_OOM), cg_delta(vals, CG_EV_OOM_KILL),
+               cg_delta(vals, CG_EV_OOM_KILL) ? "  <- oom kill" : "");
+    }
+    print_cg_io(bufs[CG_IO_STAT], elapsed);
+
+    memcpy(cg.prev, vals, sizeof(vals));
+    cg.ts = now;
+    cg.sampled = 1;
+}
+
+// 网络故障时最先看的内核计数，/proc/net/snmp 与 /proc/net/netstat 均为 "协议: 名称..." 与 "协议: 数值..." 成对的行
+struct net_counter {
+    const char *proto;
+    const char *name;
+};
+
+static const struct net_counter net_counters[] = {
+    { "TcpExt", "ListenOverflows" },
+    { "TcpExt", "ListenDrops" },
+    { "Tcp", "RetransSegs" },
+    { "TcpExt", "TCPTimeouts" },
+    { "TcpExt", "PruneCalled" },
+    { "TcpExt", "RcvPruned" },
+    { "TcpExt", "TCPMemoryPressures" },
+    { "TcpExt", "TCPAbortOnMemory" },
+    { "Udp", "InErrors" },
+    { "Udp", "RcvbufErrors" },
+    { "Udp", "SndbufErrors" },
+};
+#define NET_COUNTERS (sizeof(net_counters) / sizeof(net_counters[0]))
+
+static unsigned long long net_prev[NET_COUNTERS];
+static struct timespec net_ts;
+static int net_sampled;
+
+static bool snmp_find(const char *buf, const char *proto, const char *name, unsigned long long *val) {
+    size_t proto_len = strlen(proto), name_len = strlen(name);
+    const char *p = buf, *values;
+    int idx = 0;
+
+    do {
+        if (strncmp(p, proto, proto_len) || p[proto_len] != ':')
+            continue;
+        // 名称行在前，数值行紧随其后
+        values = p;
+        if (!proc_next_line(&values))
+            return false;
+        p += proto_len + 1;
+        while (*p == ' ') {
+            p++;
+            if (!strncmp(p, name, name_len) && (p[name_len] == ' ' || p[name_len] == '\n')) {
+                values += proto_len + 1;
+                proc_skip_fields(&values, idx);
+                *val = proc_scan_ll(&values);
+                return true;
+            }
+            proc_skip_fields(&p, 1);
+            idx++;
+        }
+        return false;
+    } while (proc_next_line(&p));
+    return false;
+}
+
+static int read_net_counters(unsigned long long *vals) {
+    const char *snmp = proc_read(&snmp_file, "/proc/net/snmp");
+    const char *netstat = proc_read(&netstat_file, "/proc/net/netstat");
+
+    if (!snmp || !netstat)
+        return -1;
+    for (size_t i = 0; i < NET_COUNTERS; i++) {
+        vals[i] = 0;
+        if (!snmp_find(snmp, net_counters[i].proto, net_counters[i].name, &vals[i]))
+            snmp_find(netstat, net_counters[i].proto, net_counters[i].name, &vals[i]);
+    }
+    return 0;
+}
+
+// 打印 TCP/UDP 关键计数在本周期的增量
+void print_net_counters() {
+    unsigned long long vals[NET_COUNTERS];
+    struct timespec now;
+
+    if (read_net_counters(vals))
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - net_ts.tv_sec) + (now.tv_nsec - net_ts.tv_nsec) / 1e9;
+
+    if (net_sampled && elapsed > 0) {
+        printf("\n[NET]\n");
+        printf("%-8s %-20s %10s %10s\n", "PROTO", "COUNTER", "DELTA", "RATE/s");
+        for (size_t i = 0; i < NET_COUNTERS; i++) {
+            unsigned long long delta = vals[i] > net_prev[i] ? vals[i] - net_prev[i] : 0;
+            printf("%-8s %-20s %10llu %10.1f\n", net_counters[i].proto, net_counters[i].name,
+                   delta, delta / elapsed);
+        }
+    }
+    memcpy(net_prev, vals, sizeof(net_prev));
+    net_ts = now;
+    net_sampled = 1;
+}
+
+// 采集首个基线，使第一个周期即可输出速率
+void init_proc_samples() {
+    if (!read_net_counters(net_prev)) {
+        clock_gettime(CLOCK_MONOTONIC, &net_ts);
+        net_sampled = 1;
+    }
+    if (!read_diskstats(&disk_samples[!disk_cur]))
+        disk_cur = !disk_cur;
+    if (read_cpu_times(&cpu_samples[!cpu_cur], &cpu_sample_len[!cpu_cur]) > 0)
+        cpu_cur = !cpu_cur;
+    if (!read_irq_table(&softirqs_file, "/proc/softirqs", &softirq_samples[!softirq_cur]))
+        softirq_cur = !softirq_cur;
+    if (!read_irq_table(&interrupts_file, "/proc/interrupts", &irq_samples[!irq_cur]))
+        irq_cur = !irq_cur;
+}
+
+// 打印软中断，每秒次数
 void print_soft_interrupts() {
-    FILE *file = fopen("/proc/softirqs", "r");
-    if (!file) {
-        perror("Could not open /proc/softirqs");
+    struct irq_table *prev = &softirq_samples[softirq_cur];
+    struct irq_table *cur = &softirq_samples[!softirq_cur];
+
+    if (read_irq_table(&softirqs_file, "/proc/softirqs", cur))
+        return;
+    softirq_cur = !softirq_cur;
+    if (!prev->nlines)
+        return;
+
+    double elapsed = irq_elapsed(prev, cur);
+    if (elapsed <= 0)
         return;
+
+    char col[16];
+    printf("\n[Soft Interrupts/s]\n%-10s", "");
+    for (int cpu = 0; cpu < cur->ncpus; cpu++) {
+        snprintf(col, sizeof(col), "CPU%d", cpu);
+        printf(" %11s", col);
+    }
+    printf("\n");
+    for (int i = 0; i < cur->nlines; i++) {
+        int pline = irq_prev_line(prev, cur, i);
+        printf("%-10s", cur->names[i]);
+        for (int cpu = 0; cpu < cur->ncpus; cpu++)
+            printf(" %11.0f", irq_delta(prev, cur, pline, i, cpu) / elapsed);
+        printf("\n");
     }
+}
 
-    char line[256];
-    printf("\n[Soft Interrupts]\n");
-    while (fgets(line, sizeof(line), file)) {
-        printf("%s", line);
+// 网卡的中断号：/sys/class/net/<dev>/device/msi_irqs 下每个文件名即一个 IRQ，
+// virtio 网卡的 msi_irqs 在上一级 PCI 设备下；都没有时按设备名前缀匹配
+static int irq_nic(int irq, const char *dev, char *nic, size_t size) {
+    struct if_nameindex *ifs = if_nameindex(), *i;
+    char path[256];
+    int found = 0;
+
+    if (!ifs)
+        return 0;
+    for (i = ifs; i->if_name && !found; i++) {
+        size_t len = strlen(i->if_name);
+        snprintf(path, sizeof(path), "/sys/class/net/%s/device/msi_irqs/%d", i->if_name, irq);
+        found = access(path, F_OK) == 0;
+        if (!found) {
+            snprintf(path, sizeof(path), "/sys/class/net/%s/device/../msi_irqs/%d", i->if_name, irq);
+            found = access(path, F_OK) == 0;
+        }
+        if (!found)
+            found = !strncmp(dev, i->if_name, len) && dev[len] == '-';
+        if (found)
+            snprintf(nic, size, "%s", i->if_name);
     }
+    if_freenameindex(ifs);
+    return found;
+}
+
+// 队列号取设备名中最后一个 '-' 或 '.' 之后的数字，如 eth0-TxRx-3、virtio0-input.1
+static int irq_queue(const char *desc) {
+    const char *p = desc + strlen(desc);
+    while (p > desc && p[-1] >= '0' && p[-1] <= '9')
+        p--;
+    if (p == desc || !*p || (p[-1] != '-' && p[-1] != '.'))
+        return -1;
+    return atoi(p);
+}
+
+static void irq_affinity(int irq, char *buf, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq);
+    FILE *file = fopen(path, "r");
+    snprintf(buf, size, "-");
+    if (!file)
+        return;
+    if (fgets(buf, size, file))
+        buf[strcspn(buf, "\n")] = '\0';
     fclose(file);
 }
 
+// 网卡接收队列的 RPS CPU 掩码（十六进制，逗号分隔的 32 位组）转成 CPU 列表，未启用时为 "-"
+static void rps_cpus(const char *nic, int queue, char *buf, size_t size) {
+    char path[128], mask[256];
+    size_t len = 0;
+    int cpu = 0, start = -1;
+
+    snprintf(buf, size, "-");
+    snprintf(path, sizeof(path), "/sys/class/net/%s/queues/rx-%d/rps_cpus", nic, queue);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return;
+    if (!fgets(mask, sizeof(mask), file))
+        mask[0] = '\0';
+    fclose(file);
+
+    // 从最低位（字符串末尾）开始逐个 CPU 扫描，连续的 CPU 合并成 a-b
+    for (int i = (int)strcspn(mask, "\n") - 1; i >= -1; i--) {
+        int nibble = 0;
+        if (i >= 0) {
+            char c = mask[i];
+            if (c == ',')
+                continue;
+            nibble = c >= 'a' ? c - 'a' + 10 : c >= 'A' ? c - 'A' + 10 : c - '0';
+        }
+        for (int bit = 0; bit < 4; bit++, cpu++) {
+            bool set = i >= 0 && (nibble >> bit & 1);
+            if (set && start < 0)
+                start = cpu;
+            if (!set && start >= 0) {
+                if (len < size)
+                    len += snprintf(buf + len, size - len, "%s%d", len ? "," : "", start);
+                if (cpu - 1 > start && len < size)
+                    len += snprintf(buf + len, size - len, "-%d", cpu - 1);
+                start = -1;
+            }
+            if (i < 0)
+                break;
+        }
+    }
+    if (!len)
+        snprintf(buf, size, "-");
+}
+
+struct irq_rate {
+    int line;
+    double total;
+    double busiest;
+    int busiest_cpu;
+};
+
+static int irq_rate_cmp(const void *a, const void *b) {
+    const struct irq_rate *x = a, *y = b;
+    return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+// 打印每秒中断数最高的 IRQ，网卡中断附带队列号及 CPU 亲和性
+void print_interrupts() {
+    struct irq_table *prev = &irq_samples[irq_cur];
+    struct irq_table *cur = &irq_samples[!irq_cur];
+
+    if (read_irq_table(&interrupts_file, "/proc/interrupts", cur))
+        return;
+    irq_cur = !irq_cur;
+    if (!prev->nlines)
+        return;
+
+    double elapsed = irq_elapsed(prev, cur);
+    if (elapsed <= 0)
+        return;
+
+    struct irq_rate *rates = calloc(cur->nlines, sizeof(*rates));
+    if (!rates)
+        return;
+    int nrates = 0;
+    for (int i = 0; i < cur->nlines; i++) {
+        // 只看编号中断，LOC/RES 等 CPU 本地中断不涉及亲和性
+        if (cur->names[i][0] < '0' || cur->names[i][0] > '9')
+            continue;
+        struct irq_rate *r = &rates[nrates];
+        int pline = irq_prev_line(prev, cur, i);
+        r->line = i;
+        r->total = 0;
+        r->busiest = -1;
+        for (int cpu = 0; cpu < cur->ncpus; cpu++) {
+            double rate = irq_delta(prev, cur, pline, i, cpu) / elapsed;
+            r->total += rate;
+            if (rate > r->busiest) {
+                r->busiest = rate;
+                r->busiest_cpu = cpu;
+            }
+        }
+        if (r->total > 0)
+            nrates++;
+    }
+    qsort(rates, nrates, sizeof(*rates), irq_rate_cmp);
+
+    printf("\n[Interrupts/s]\n");
+    printf("%-5s %10s %8s %6s %-12s %5s %-16s %-16s %s\n",
+           "IRQ", "TOTAL/s", "TOP_CPU", "TOP%", "NIC", "QUEUE", "AFFINITY", "RPS_CPUS", "DEVICE");
+    for (int i = 0; i < nrates && i < IRQ_ROWS; i++) {
+        struct irq_rate *r = &rates[i];
+        int irq = atoi(cur->names[r->line]);
+        char nic[IF_NAMESIZE] = "-", affinity[64], queue[8] = "-", rps[64] = "-";
+        // 描述的最后一列是设备名，前面是中断控制器及触发方式
+        const char *dev = strrchr(cur->descs[r->line], ' ');
+        dev = dev ? dev + 1 : cur->descs[r->line];
+
+        if (irq_nic(irq, dev, nic, sizeof(nic)) && irq_queue(dev) >= 0) {
+            snprintf(queue, sizeof(queue), "%d", irq_queue(dev));
+            rps_cpus(nic, irq_queue(dev), rps, sizeof(rps));
+        }
+        irq_affinity(irq, affinity, sizeof(affinity));
+        printf("%-5d %10.0f %8d %6.1f %-12s %5s %-16s %-16s %s\n",
+               irq, r->total, r->busiest_cpu, 100.0 * r->busiest / r->total,
+               nic, queue, affinity, rps, dev);
+    }
+    free(rates);
+}
+
 // 打印最大进程线程数
 void print_nproc_limit() {
     struct rlimit rl;
@@ -117,20 +1160,15 @@ void print_nproc_limit() {
     }
 }
 
-// 打印TCP backlog限制
-void print_tcp_backlog() {
-    FILE *file = fopen("/proc/sys/net/core/somaxconn", "r");
-    if (!file) {
-        perror("Could not open /proc/sys/net/core/somaxconn");
-        return;
-    }
+// 打印TCP backlog限制，返回 somaxconn，失败返回 -1
+int print_tcp_backlog() {
+    const char *p = proc_read(&somaxconn_file, "/proc/sys/net/core/somaxconn");
+    if (!p)
+        return -1;
 
-    int somaxconn;
-    if(fscanf(file, "%d", &somaxconn)!=1){
-       perror("print_tcp_backlog");
-    }
+    int somaxconn = proc_scan_ll(&p);
     printf("TCP Backlog (somaxconn): %d\n", somaxconn);
-    fclose(file);
+    return somaxconn;
 }
 
 // 打印swap信息
@@ -143,23 +1181,397 @@ void print_swap_info() {
     }
 }
 
-void get_process_cpu_time(int pid, unsigned long *total_time) {
-    char stat_filepath[256];
-    unsigned long utime, stime, cutime, cstime;
-    snprintf(stat_filepath, sizeof(stat_filepath), "/proc/%d/stat", pid);
+#define MAX_NUMA_NODES 64
+
+enum { NUMA_HIT, NUMA_MISS, NUMA_FOREIGN, NUMA_OTHER, NUMASTAT_FIELDS };
+static const char *numastat_keys[NUMASTAT_FIELDS] = {
+    "numa_hit", "numa_miss", "numa_foreign", "other_node",
+};
+
+struct numa_node {
+    int id;
+    char cpulist[64];
+    unsigned long long stat[NUMASTAT_FIELDS];
+    struct proc_file meminfo;
+    struct proc_file numastat;
+};
 
-    FILE *file = fopen(stat_filepath, "r");
-    if (!file) {
-        perror("Could not open stat file");
+static struct numa_node numa_nodes[MAX_NUMA_NODES];
+static int nr_numa_nodes = -1;
+static int *cpu_node;       // CPU 号到 node 下标
+static int nr_cpu_node;
+static struct timespec numa_ts;
+static struct proc_file pid_numa_maps_file = PROC_FILE_INIT;
+static pid_t pid_numa_maps_pid;
+// 读 numa_maps 要在 mmap 锁下遍历目标进程的全部页表，大内存进程代价高，结果缓存 NUMA_MAPS_REFRESH_SEC 秒
+#define NUMA_MAPS_REFRESH_SEC 10
+static unsigned long long numa_maps_kb[MAX_NUMA_NODES];
+static struct timespec numa_maps_ts;
+
+// 解析 cpulist，如 "0-3,8-11"，把其中的 CPU 映射到 node 下标
+static void map_node_cpus(const char *p, int node) {
+    while (*p >= '0' && *p <= '9') {
+        int lo = proc_scan_ull(&p), hi = lo;
+        if (*p == '-') {
+            p++;
+            hi = proc_scan_ull(&p);
+        }
+        if (hi >= nr_cpu_node) {
+            int *grown = realloc(cpu_node, (hi + 1) * sizeof(*cpu_node));
+            if (!grown)
+                return;
+            for (int i = nr_cpu_node; i <= hi; i++)
+                grown[i] = -1;
+            cpu_node = grown;
+            nr_cpu_node = hi + 1;
+        }
+        for (int cpu = lo; cpu <= hi; cpu++)
+            cpu_node[cpu] = node;
+        if (*p != ',')
+            break;
+        p++;
+    }
+}
+
+static int node_id_cmp(const void *a, const void *b) {
+    return ((const struct numa_node *)a)->id - ((const struct numa_node *)b)->id;
+}
+
+// 拓扑只在第一次加载；node 编号可能不连续
+static void load_numa_nodes() {
+    DIR *dir = opendir("/sys/devices/system/node");
+    struct dirent *ent;
+    char path[128];
+
+    nr_numa_nodes = 0;
+    if (!dir)
         return;
+    while ((ent = readdir(dir)) && nr_numa_nodes < MAX_NUMA_NODES) {
+        if (strncmp(ent->d_name, "node", 4) || ent->d_name[4] < '0' || ent->d_name[4] > '9')
+            continue;
+        struct numa_node *n = &numa_nodes[nr_numa_nodes++];
+        n->id = atoi(ent->d_name + 4);
+        n->meminfo.fd = -1;
+        n->numastat.fd = -1;
     }
+    closedir(dir);
+    qsort(numa_nodes, nr_numa_nodes, sizeof(numa_nodes[0]), node_id_cmp);
+
+    for (int i = 0; i < nr_numa_nodes; i++) {
+        struct proc_file f = PROC_FILE_INIT;
+        const char *p;
 
-    // Skip initial fields and read utime and stime
-    if(fscanf(file, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %lu %lu",
-           &utime, &stime, &cutime, &cstime)!=1){
-    	perror("get_process_cpu_time error");
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numa_nodes[i].id);
+        if (proc_file__open(&f, path))
+            continue;
+        if ((p = proc_file__read(&f))) {
+            snprintf(numa_nodes[i].cpulist, sizeof(numa_nodes[i].cpulist), "%.*s",
+                     (int)strcspn(p, "\n"), p);
+            map_node_cpus(p, i);
+        }
+        proc_file__close(&f);
     }
-    fclose(file);
+}
+
+// CPU 所在 node 的下标，未知时返回 -1
+static int node_of_cpu(int cpu) {
+    if (nr_numa_nodes < 0)
+        load_numa_nodes();
+    return cpu >= 0 && cpu < nr_cpu_node ? cpu_node[cpu] : -1;
+}
+
+// 目标进程的线程，按 tid 排序；每个线程的 stat 文件常驻打开
+struct thread_sample {
+    pid_t tid;
+    char comm[16];
+    unsigned long long utime;
+    unsigned long long stime;
+    double usr_pct;
+    double sys_pct;
+    int cpu;        // 最近一次运行的 CPU
+    int prev_cpu;   // 上个周期的 CPU，-1 表示新线程
+    struct proc_file file;
+};
+
+static struct thread_sample *threads, *prev_threads;
+static int nthreads, nprev_threads, threads_cap, prev_threads_cap;
+static struct timespec threads_ts;
+// 常驻打开的线程 stat 文件上限，超出的线程每次 open/read/close，避免耗尽 RLIMIT_NOFILE
+#define MAX_THREAD_FDS 256
+
+#define THREAD_ROWS 20
+
+static int thread_tid_cmp(const void *a, const void *b) {
+    const struct thread_sample *x = a, *y = b;
+    return x->tid - y->tid;
+}
+
+static int thread_cpu_cmp(const void *a, const void *b) {
+    const struct thread_sample *x = *(const struct thread_sample **)a;
+    const struct thread_sample *y = *(const struct thread_sample **)b;
+    double cx = x->usr_pct + x->sys_pct, cy = y->usr_pct + y->sys_pct;
+    return cx < cy ? 1 : cx > cy ? -1 : 0;
+}
+
+// 读取 /proc/<pid>/task/<tid>/stat 中的线程名、utime、stime
+static int read_thread_stat(pid_t pid, struct thread_sample *t) {
+    char path[64];
+    const char *p, *comm;
+
+    if (!proc_file__is_open(&t->file)) {
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, t->tid);
+        if (proc_file__open(&t->file, path))
+            return -1;
+    }
+    p = proc_file__read(&t->file);
+    if (!p || !(comm = strchr(p, '(')) || !(p = strrchr(p, ')')))
+        return -1;
+    snprintf(t->comm, sizeof(t->comm), "%.*s", (int)(p - comm - 1), comm + 1);
+    p++;
+    proc_skip_fields(&p, 11);
+    t->utime = proc_scan_ull(&p);
+    t->stime = proc_scan_ull(&p);
+    // 第 39 列 processor
+    proc_skip_fields(&p, 23);
+    t->cpu = proc_scan_ll(&p);
+    return 0;
+}
+
+// 采样目标进程所有线程，与上次采样按 tid 对齐计算 CPU 占比
+static void sample_threads(pid_t pid) {
+    char path[64];
+    struct dirent *ent;
+    struct thread_sample *t, *old, *swap;
+    struct timespec now;
+    int cap;
+
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return;
+    }
+
+    // 上一次的采样变为 prev，复用其数组存放本次采样
+    swap = prev_threads;
+    prev_threads = threads;
+    threads = swap;
+    cap = prev_threads_cap;
+    prev_threads_cap = threads_cap;
+    threads_cap = cap;
+    nprev_threads = nthreads;
+    nthreads = 0;
+
+    while ((ent = readdir(dir))) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+            continue;
+        if (nthreads == threads_cap) {
+            cap = threads_cap ? threads_cap * 2 : 64;
+            swap = realloc(threads, cap * sizeof(*threads));
+            if (!swap)
+                break;
+            threads = swap;
+            threads_cap = cap;
+        }
+        t = &threads[nthreads++];
+        memset(t, 0, sizeof(*t));
+        t->tid = atoi(ent->d_name);
+        t->prev_cpu = -1;
+        t->file.fd = -1;
+    }
+    closedir(dir);
+    qsort(threads, nthreads, sizeof(*threads), thread_tid_cmp);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - threads_ts.tv_sec) + (now.tv_nsec - threads_ts.tv_nsec) / 1e9;
+    double ticks = sysconf(_SC_CLK_TCK);
+    threads_ts = now;
+
+    int nfds = 0;
+    for (int i = 0; i < nthreads; i++) {
+        t = &threads[i];
+        old = nprev_threads ? bsearch(t, prev_threads, nprev_threads, sizeof(*t), thread_tid_cmp) : NULL;
+        if (old) {
+            // 接管上次打开的 fd
+            t->file = old->file;
+            t->prev_cpu = old->cpu;
+            old->file.fd = -1;
+            old->file.buf = NULL;
+        }
+        if (read_thread_stat(pid, t)) {
+            proc_file__close(&t->file);
+            continue;
+        }
+        if (nfds < MAX_THREAD_FDS)
+            nfds++;
+        else
+            proc_file__close(&t->file);
+        if (old && elapsed > 0) {
+            t->usr_pct = 100.0 * (t->utime - old->utime) / ticks / elapsed;
+            t->sys_pct = 100.0 * (t->stime - old->stime) / ticks / elapsed;
+        }
+    }
+    // 已退出的线程
+    for (int i = 0; i < nprev_threads; i++)
+        proc_file__close(&prev_threads[i].file);
+}
+
+// 线程最近一个周期的 CPU 占比，不是目标进程的线程返回 -1
+double get_thread_cpu_usage(pid_t tid) {
+    struct thread_sample key = { .tid = tid }, *t;
+
+    if (!nthreads || !nprev_threads)
+        return -1;
+    t = bsearch(&key, threads, nthreads, sizeof(key), thread_tid_cmp);
+    return t ? t->usr_pct + t->sys_pct : -1;
+}
+
+static void print_thread_usage() {
+    struct thread_sample **rows;
+    int n = 0;
+
+    if (!nprev_threads)
+        return;
+    rows = malloc(nthreads * sizeof(*rows));
+    if (!rows)
+        return;
+    for (int i = 0; i < nthreads; i++)
+        rows[n++] = &threads[i];
+    qsort(rows, n, sizeof(*rows), thread_cpu_cmp);
+
+    printf("%-7s %-16s %6s %6s %6s %4s %4s\n", "TID", "COMM", "CPU%", "USR%", "SYS%",
+           "CPU", "NODE");
+    for (int i = 0; i < n && i < THREAD_ROWS; i++)
+        printf("%-7d %-16s %6.1f %6.1f %6.1f %4d %4d\n", rows[i]->tid, rows[i]->comm,
+               rows[i]->usr_pct + rows[i]->sys_pct, rows[i]->usr_pct, rows[i]->sys_pct,
+               rows[i]->cpu, node_of_cpu(rows[i]->cpu) >= 0 ?
+               numa_nodes[node_of_cpu(rows[i]->cpu)].id : -1);
+    free(rows);
+}
+
+// /proc/<pid>/numa_maps 每行的 N<node>=<pages>，按该行 kernelpagesize_kB 换算成 kB
+static void read_pid_numa_kb(pid_t pid, unsigned long long *out) {
+    unsigned long long pages[MAX_NUMA_NODES], *kb = numa_maps_kb;
+    struct timespec now;
+    const char *p;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (pid == pid_numa_maps_pid && numa_maps_ts.tv_sec &&
+        now.tv_sec - numa_maps_ts.tv_sec < NUMA_MAPS_REFRESH_SEC) {
+        memcpy(out, numa_maps_kb, sizeof(numa_maps_kb));
+        return;
+    }
+    p = proc_read_pid(&pid_numa_maps_file, &pid_numa_maps_pid, pid, "numa_maps");
+    if (!p)
+        return;
+    numa_maps_ts = now;
+    memset(numa_maps_kb, 0, sizeof(numa_maps_kb));
+    do {
+        unsigned long long page_kb = 4;
+        const char *end = p + strcspn(p, "\n");
+
+        memset(pages, 0, sizeof(pages));
+        for (const char *q = p + strspn(p, " "); q < end; q += strspn(q, " ")) {
+            if (q[0] == 'N' && q[1] >= '0' && q[1] <= '9') {
+                q++;
+                int id = proc_scan_ull(&q);
+                if (*q == '=') {
+                    q++;
+                    for (int i = 0; i < nr_numa_nodes; i++)
+                        if (numa_nodes[i].id == id)
+                            pages[i] = proc_scan_ull(&q);
+                }
+            } else if (!strncmp(q, "kernelpagesize_kB=", 18)) {
+                q += 18;
+                page_kb = proc_scan_ull(&q);
+            }
+            // 跳过本字段剩余部分
+            q += strcspn(q, " \n");
+        }
+        for (int i = 0; i < nr_numa_nodes; i++)
+            kb[i] += pages[i] * page_kb;
+    } while (proc_next_line(&p));
+    memcpy(out, numa_maps_kb, sizeof(numa_maps_kb));
+}
+
+// 每个 node 的内存、numastat 速率，以及目标进程在各 node 上的内存和线程
+void print_numa(pid_t pid) {
+    unsigned long long pid_kb[MAX_NUMA_NODES] = {0};
+    int node_threads[MAX_NUMA_NODES] = {0};
+    int moved = 0;
+    char path[128], key[32];
+    struct timespec now;
+
+    if (nr_numa_nodes < 0)
+        load_numa_nodes();
+    // 单 node 机器没有本地性问题
+    if (nr_numa_nodes < 2)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - numa_ts.tv_sec) + (now.tv_nsec - numa_ts.tv_nsec) / 1e9;
+    bool have_prev = numa_ts.tv_sec != 0 && elapsed > 0;
+    numa_ts = now;
+
+    if (pid != 0) {
+        read_pid_numa_kb(pid, pid_kb);
+        // 线程表由 print_cpu_usage 在本周期刚采样过
+        for (int i = 0; i < nthreads; i++) {
+            int node = node_of_cpu(threads[i].cpu);
+            if (node >= 0)
+                node_threads[node]++;
+            if (threads[i].prev_cpu >= 0 && node_of_cpu(threads[i].prev_cpu) != node)
+                moved++;
+        }
+    }
+
+    printf("\n[numa]\n");
+    printf("%-4s %-16s %9s %9s %9s %9s %9s %9s %9s %7s\n", "NODE", "CPUS", "MEM_MB", "FREE_MB",
+           "HIT/s", "MISS/s", "FOREIGN/s", "OTHER/s", "PID_MB", "THREADS");
+    for (int i = 0; i < nr_numa_nodes; i++) {
+        struct numa_node *n = &numa_nodes[i];
+        unsigned long long total = 0, free = 0, stat[NUMASTAT_FIELDS] = {0};
+        double rate[NUMASTAT_FIELDS] = {0};
+        const char *p;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", n->id);
+        if ((p = proc_read(&n->meminfo, path))) {
+            snprintf(key, sizeof(key), "Node %d MemTotal:", n->id);
+            proc_find_ull(p, key, &total);
+            snprintf(key, sizeof(key), "Node %d MemFree:", n->id);
+            proc_find_ull(p, key, &free);
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/numastat", n->id);
+        if ((p = proc_read(&n->numastat, path))) {
+            for (int f = 0; f < NUMASTAT_FIELDS; f++) {
+                snprintf(key, sizeof(key), "%s ", numastat_keys[f]);
+                proc_find_ull(p, key, &stat[f]);
+                if (have_prev && stat[f] > n->stat[f])
+                    rate[f] = (stat[f] - n->stat[f]) / elapsed;
+                n->stat[f] = stat[f];
+            }
+        }
+        printf("%-4d %-16s %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.1f %7d\n", n->id, n->cpulist,
+               total / 1024.0, free / 1024.0, rate[NUMA_HIT], rate[NUMA_MISS],
+               rate[NUMA_FOREIGN], rate[NUMA_OTHER], pid_kb[i] / 1024.0, node_threads[i]);
+    }
+    if (pid != 0)
+        printf("threads moved to another node since last interval: %d\n", moved);
+}
+
+void get_process_cpu_time(int pid, unsigned long *total_time) {
+    const char *p = proc_read_pid(&pid_stat_file, &pid_stat_pid, pid, "stat");
+    unsigned long utime, stime, cutime, cstime;
+
+    // comm 可能包含空格和括号，从最后一个 ')' 之后开始，跳过 state 到 cmajflt
+    if (!p || !(p = strrchr(p, ')')))
+        return;
+    p++;
+    proc_skip_fields(&p, 11);
+    utime = proc_scan_ull(&p);
+    stime = proc_scan_ull(&p);
+    cutime = proc_scan_ull(&p);
+    cstime = proc_scan_ull(&p);
 
     *total_time = utime + stime + cutime + cstime;
 }
@@ -170,6 +1582,7 @@ void print_cpu_usage(pid_t pid) {
     long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
     printf("\n[cpu]\n");
     printf("Number of CPU cores: %ld\n", nprocs);
+    print_cpu_breakdown();
     if(pid == 0){
         return;
     }
@@ -177,26 +1590,149 @@ void print_cpu_usage(pid_t pid) {
     long ticks_per_second = sysconf(_SC_CLK_TCK);
     get_process_cpu_time(pid, &total_time);
     time_t now = time(NULL);
-    if(last_process_cpu_time == 0 || now - last_process_cpu_time == 0){
+    sample_threads(pid);
+    if(last_process_cpu_time == 0 || now - last_cpu_time == 0){
         last_cpu_time = now;
         last_process_cpu_time = total_time;
         return;
     }
     // Calculate CPU usage percentage based on clock ticks per second
     double cpu_usage = (100.0 * (total_time - last_process_cpu_time) / ticks_per_second)/(now - last_cpu_time);
-    printf("now: %ld,last_cpu_time: %ld,total_time: %ld,ticks_per_second: %ld\n",now,last_cpu_time,total_time,ticks_per_second);
     last_cpu_time = now;
     last_process_cpu_time = total_time;
     cpu_usage = cpu_usage > 100 ? 100 : cpu_usage;
 
     printf("CPU usage for process %d: %.2f%%\n", pid, cpu_usage);
+    print_thread_usage();
 
 }
 
-void print_proc_limits(){
+#define LIMIT_WARN_PCT 80
+
+// /proc/<pid>/limits 中一项的软/硬限制，unlimited 记为 -1
+static void parse_limit(const char *buf, const char *name, long long *soft, long long *hard) {
+    const char *p = strstr(buf, name);
+
+    *soft = *hard = -1;
+    if (!p)
+        return;
+    p += strlen(name);
+    p += strspn(p, " ");
+    if (strncmp(p, "unlimited", 9))
+        *soft = proc_scan_ll(&p);
+    else
+        p += 9;
+    p += strspn(p, " ");
+    if (strncmp(p, "unlimited", 9))
+        *hard = proc_scan_ll(&p);
+}
+
+// 目录下的数字项个数，用于统计 fd 数
+static long count_dir_entries(const char *path) {
+    DIR *dir = opendir(path);
+    struct dirent *ent;
+    long n = 0;
+
+    if (!dir)
+        return -1;
+    while ((ent = readdir(dir)))
+        if (ent->d_name[0] >= '0' && ent->d_name[0] <= '9')
+            n++;
+    closedir(dir);
+    return n;
+}
+
+// RLIMIT_NPROC 按真实 uid 统计线程数；需要遍历所有进程，结果缓存 USER_THREADS_REFRESH_SEC 秒
+#define USER_THREADS_REFRESH_SEC 10
+
+static long count_user_threads(uid_t uid) {
+    static long cached = -1;
+    static uid_t cached_uid;
+    static struct timespec cached_ts;
+    struct timespec now;
+    DIR *dir;
+    struct dirent *ent;
+    char path[64];
+    const char *p;
+    unsigned long long ruid, threads;
+    long n = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (cached >= 0 && cached_uid == uid && now.tv_sec - cached_ts.tv_sec < USER_THREADS_REFRESH_SEC)
+        return cached;
+
+    dir = opendir("/proc");
+    if (!dir)
+        return -1;
+    while ((ent = readdir(dir))) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+            continue;
+        struct proc_file f = PROC_FILE_INIT;
+        snprintf(path, sizeof(path), "/proc/%d/status", atoi(ent->d_name));
+        if (proc_file__open(&f, path))
+            continue;
+        p = proc_file__read(&f);
+        // "Uid:" 第一列为真实 uid
+        if (p && proc_find_ull(p, "Uid:", &ruid) && ruid == uid &&
+            proc_find_ull(p, "Threads:", &threads))
+            n += threads;
+        proc_file__close(&f);
+    }
+    closedir(dir);
+    cached = n;
+    cached_uid = uid;
+    cached_ts = now;
+    return n;
+}
+
+static void print_limit_row(const char *name, long long used, long long soft, long long hard) {
+    char soft_buf[24], hard_buf[24], pct_buf[16] = "-";
+    double pct = -1;
+
+    snprintf(soft_buf, sizeof(soft_buf), soft < 0 ? "unlimited" : "%lld", soft);
+    snprintf(hard_buf, sizeof(hard_buf), hard < 0 ? "unlimited" : "%lld", hard);
+    if (soft > 0 && used >= 0) {
+        pct = 100.0 * used / soft;
+        snprintf(pct_buf, sizeof(pct_buf), "%.1f", pct);
+    }
+    printf("%-14s %12lld %12s %12s %6s%s\n", name, used, soft_buf, hard_buf, pct_buf,
+           pct >= LIMIT_WARN_PCT ? "  <- near limit" : "");
+}
+
+// 目标进程的 fd、进程数、锁定内存的使用量与限制
+static void print_pid_limits(pid_t pid) {
+    const char *limits = proc_read_pid(&pid_limits_file, &pid_limits_pid, pid, "limits");
+    const char *status = proc_read_pid(&pid_status_file, &pid_status_pid, pid, "status");
+    long long soft, hard;
+    unsigned long long vmlck = 0, ruid;
+    char path[64];
+
+    if (!limits || !status)
+        return;
+
+    printf("%-14s %12s %12s %12s %6s\n", "LIMIT", "USED", "SOFT", "HARD", "USE%");
+    snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+    parse_limit(limits, "Max open files", &soft, &hard);
+    print_limit_row("open files", count_dir_entries(path), soft, hard);
+
+    parse_limit(limits, "Max processes", &soft, &hard);
+    print_limit_row("processes", proc_find_ull(status, "Uid:", &ruid) ? count_user_threads(ruid) : -1,
+                    soft, hard);
+
+    proc_find_ull(status, "VmLck:", &vmlck);
+    parse_limit(limits, "Max locked memory", &soft, &hard);
+    print_limit_row("locked memory", vmlck * 1024, soft, hard);
+}
+
+void print_proc_limits(pid_t pid){
     printf("[sys limits]\n");
-    print_file_handle_limit();
-    print_nproc_limit();
+    // 指定 -p 时显示目标进程的限制，而不是 systool 自身的
+    if (pid != 0)
+        print_pid_limits(pid);
+    else {
+        print_file_handle_limit();
+        print_nproc_limit();
+    }
     print_swap_info();
 }
     
@@ -204,9 +1740,11 @@ void print_proc_limits(){
 // 主函数
 void print_system_limits(pid_t pid) {
     print_loadavg();
-    print_proc_limits();
+    print_proc_limits(pid);
     print_cpu_usage(pid);
     print_mem(pid);
+    print_numa(pid);
     print_soft_interrupts();
+    print_interrupts();
 }
 
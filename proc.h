@@ -1,8 +1,15 @@
 #ifndef __PROC_H
 #define __PROC_H
 
+#include <sys/types.h>
+
 void print_system_limits();
 void set_last_time();
-void print_tcp_backlog();
+void init_proc_samples();
+int print_tcp_backlog();
+void print_diskstats();
+void print_net_counters();
+void print_cgroup_stats(pid_t pid, const char *cgroup);
+double get_thread_cpu_usage(pid_t tid);
 
 #endif
\ No newline at end of file
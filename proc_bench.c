@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: (LGPL-2.1 OR BSD-2-Clause)
+/*
+ * Compares the fopen/fgets/sscanf way of sampling /proc with proc_file's
+ * persistent fd, pread and hand-written scanner.
+ *
+ * USAGE: proc_bench [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "proc_file.h"
+
+#define DEFAULT_ITERS	20000
+
+struct sample {
+	unsigned long long mem_total;
+	unsigned long long utime;
+	unsigned long long cpu_user;
+	double load1;
+};
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sample_stdio(struct sample *s)
+{
+	char line[512];
+	FILE *f;
+
+	f = fopen("/proc/meminfo", "r");
+	if (f) {
+		while (fgets(line, sizeof(line), f))
+			if (sscanf(line, "MemTotal: %llu kB", &s->mem_total) == 1)
+				break;
+		fclose(f);
+	}
+	f = fopen("/proc/self/stat", "r");
+	if (f) {
+		if (fscanf(f, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu",
+			   &s->utime) != 1)
+			s->utime = 0;
+		fclose(f);
+	}
+	f = fopen("/proc/stat", "r");
+	if (f) {
+		if (fscanf(f, "cpu %llu", &s->cpu_user) != 1)
+			s->cpu_user = 0;
+		fclose(f);
+	}
+	f = fopen("/proc/loadavg", "r");
+	if (f) {
+		if (fscanf(f, "%lf", &s->load1) != 1)
+			s->load1 = 0;
+		fclose(f);
+	}
+}
+
+static struct proc_file meminfo = PROC_FILE_INIT;
+static struct proc_file self_stat = PROC_FILE_INIT;
+static struct proc_file proc_stat = PROC_FILE_INIT;
+static struct proc_file loadavg = PROC_FILE_INIT;
+
+static void sample_proc_file(struct sample *s)
+{
+	const char *p;
+
+	if ((p = proc_file__read(&meminfo)))
+		proc_find_ull(p, "MemTotal:", &s->mem_total);
+	if ((p = proc_file__read(&self_stat)) && (p = strrchr(p, ')'))) {
+		p++;
+		proc_skip_fields(&p, 11);
+		s->utime = proc_scan_ull(&p);
+	}
+	if ((p = proc_file__read(&proc_stat))) {
+		proc_skip_fields(&p, 1);
+		s->cpu_user = proc_scan_ull(&p);
+	}
+	if ((p = proc_file__read(&loadavg)))
+		s->load1 = proc_scan_double(&p);
+}
+
+static double bench(void (*fn)(struct sample *), struct sample *s, int iters)
+{
+	unsigned long long start = now_ns();
+	int i;
+
+	for (i = 0; i < iters; i++)
+		fn(s);
+	return (double)(now_ns() - start) / iters;
+}
+
+int main(int argc, char **argv)
+{
+	int iters = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERS;
+	struct sample a = {}, b = {};
+	double stdio_ns, proc_file_ns;
+
+	if (iters <= 0) {
+		fprintf(stderr, "USAGE: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+	if (proc_file__open(&meminfo, "/proc/meminfo") ||
+	    proc_file__open(&self_stat, "/proc/self/stat") ||
+	    proc_file__open(&proc_stat, "/proc/stat") ||
+	    proc_file__open(&loadavg, "/proc/loadavg")) {
+		perror("proc_file__open");
+		return 1;
+	}
+
+	/* warm up caches and buffers, and check both parse the same values */
+	sample_stdio(&a);
+	sample_proc_file(&b);
+	if (a.mem_total != b.mem_total || (int)(a.load1 * 100) != (int)(b.load1 * 100))
+		fprintf(stderr, "warning: parsers disagree: MemTotal %llu/%llu load1 %.2f/%.2f\n",
+			a.mem_total, b.mem_total, a.load1, b.load1);
+
+	stdio_ns = bench(sample_stdio, &a, iters);
+	proc_file_ns = bench(sample_proc_file, &b, iters);
+
+	printf("%-24s %12s\n", "READER", "ns/sample");
+	printf("%-24s %12.0f\n", "fopen+fgets+sscanf", stdio_ns);
+	printf("%-24s %12.0f\n", "proc_file pread+scan", proc_file_ns);
+	printf("speedup: %.2fx (%d iterations, 4 files per sample)\n",
+	       stdio_ns / proc_file_ns, iters);
+
+	proc_file__close(&meminfo);
+	proc_file__close(&self_stat);
+	proc_file__close(&proc_stat);
+	proc_file__close(&loadavg);
+	return 0;
+}
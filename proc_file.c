@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: (LGPL-2.1 OR BSD-2-Clause)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "proc_file.h"
+
+#define PROC_FILE_MIN_SIZE	4096
+
+int proc_file__open(struct proc_file *f, const char *path)
+{
+	f->fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (f->fd < 0)
+		return -errno;
+	f->len = 0;
+	return 0;
+}
+
+char *proc_file__read(struct proc_file *f)
+{
+	ssize_t n;
+	char *buf;
+
+	if (f->fd < 0) {
+		errno = EBADF;
+		return NULL;
+	}
+
+	f->len = 0;
+	while (1) {
+		/* keep one byte for the terminating NUL */
+		if (f->len + 1 >= f->size) {
+			size_t size = f->size ? f->size * 2 : PROC_FILE_MIN_SIZE;
+
+			buf = realloc(f->buf, size);
+			if (!buf)
+				return NULL;
+			f->buf = buf;
+			f->size = size;
+		}
+		n = pread(f->fd, f->buf + f->len, f->size - f->len - 1, f->len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return NULL;
+		}
+		if (n == 0)
+			break;
+		f->len += n;
+	}
+	f->buf[f->len] = '\0';
+	return f->buf;
+}
+
+void proc_file__close(struct proc_file *f)
+{
+	if (f->fd >= 0)
+		close(f->fd);
+	free(f->buf);
+	f->fd = -1;
+	f->buf = NULL;
+	f->size = 0;
+	f->len = 0;
+}
+
+static const char *skip_blanks(const char *p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+unsigned long long proc_scan_ull(const char **p)
+{
+	const char *s = skip_blanks(*p);
+	unsigned long long val = 0;
+
+	while (*s >= '0' && *s <= '9')
+		val = val * 10 + (*s++ - '0');
+	*p = s;
+	return val;
+}
+
+long long proc_scan_ll(const char **p)
+{
+	const char *s = skip_blanks(*p);
+	bool neg = *s == '-';
+
+	if (neg)
+		s++;
+	*p = s;
+	return neg ? -(long long)proc_scan_ull(p) : (long long)proc_scan_ull(p);
+}
+
+double proc_scan_double(const char **p)
+{
+	double val, scale = 1;
+
+	val = proc_scan_ull(p);
+	if (**p != '.')
+		return val;
+	(*p)++;
+	while (**p >= '0' && **p <= '9') {
+		scale /= 10;
+		val += (*(*p)++ - '0') * scale;
+	}
+	return val;
+}
+
+void proc_skip_fields(const char **p, int n)
+{
+	const char *s = *p;
+
+	while (n-- > 0) {
+		s = skip_blanks(s);
+		while (*s && *s != ' ' && *s != '\t' && *s != '\n')
+			s++;
+	}
+	*p = s;
+}
+
+bool proc_next_line(const char **p)
+{
+	const char *s = strchr(*p, '\n');
+
+	if (!s || !s[1])
+		return false;
+	*p = s + 1;
+	return true;
+}
+
+bool proc_find_ull(const char *buf, const char *key, unsigned long long *val)
+{
+	size_t len = strlen(key);
+	const char *p = buf;
+
+	do {
+		if (!strncmp(p, key, len)) {
+			p += len;
+			*val = proc_scan_ull(&p);
+			return true;
+		}
+	} while (proc_next_line(&p));
+	return false;
+}
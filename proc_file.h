@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: (LGPL-2.1 OR BSD-2-Clause) */
+#ifndef __PROC_FILE_H
+#define __PROC_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A /proc or /sys file kept open across intervals. Each read re-reads the
+ * whole file with pread() at offset 0 into a buffer that is reused, so a
+ * sample costs no open/close and no allocation once the buffer has grown.
+ */
+struct proc_file {
+	int fd;
+	char *buf;
+	size_t size;
+	size_t len;
+};
+
+#define PROC_FILE_INIT	{ .fd = -1 }
+
+int proc_file__open(struct proc_file *f, const char *path);
+/* Returns the NUL-terminated contents, or NULL with errno set. */
+char *proc_file__read(struct proc_file *f);
+void proc_file__close(struct proc_file *f);
+static inline bool proc_file__is_open(const struct proc_file *f)
+{
+	return f->fd >= 0;
+}
+
+/*
+ * Scanner over the buffer. Each helper skips leading blanks and advances
+ * *p past what it consumed; they never allocate or copy.
+ */
+unsigned long long proc_scan_ull(const char **p);
+long long proc_scan_ll(const char **p);
+double proc_scan_double(const char **p);
+void proc_skip_fields(const char **p, int n);
+/* Advances to the next line, returns false at the end of the buffer. */
+bool proc_next_line(const char **p);
+/* Value following "key" at the start of a line, e.g. "MemTotal:". */
+bool proc_find_ull(const char *buf, const char *key, unsigned long long *val);
+
+#endif /* __PROC_FILE_H */
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: (LGPL-2.1 OR BSD-2-Clause)
+/*
+ * Minimal inet_diag client: one request per family over a netlink socket
+ * that is kept open between intervals.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include "sock_diag.h"
+
+#define MAX_FILTER_PORTS	64
+
+static int diag_fd = -1;
+
+static const char *tcp_states[] = {
+	[TCP_ESTABLISHED]	= "ESTAB",
+	[TCP_SYN_SENT]		= "SYN-SENT",
+	[TCP_SYN_RECV]		= "SYN-RECV",
+	[TCP_FIN_WAIT1]		= "FIN-WAIT-1",
+	[TCP_FIN_WAIT2]		= "FIN-WAIT-2",
+	[TCP_TIME_WAIT]		= "TIME-WAIT",
+	[TCP_CLOSE]		= "CLOSE",
+	[TCP_CLOSE_WAIT]	= "CLOSE-WAIT",
+	[TCP_LAST_ACK]		= "LAST-ACK",
+	[TCP_LISTEN]		= "LISTEN",
+	[TCP_CLOSING]		= "CLOSING",
+};
+
+const char *sock_diag__state_name(int state)
+{
+	if (state <= 0 || state >= (int)(sizeof(tcp_states) / sizeof(tcp_states[0])) ||
+	    !tcp_states[state])
+		return "UNKNOWN";
+	return tcp_states[state];
+}
+
+void sock_diag__close(void)
+{
+	if (diag_fd >= 0)
+		close(diag_fd);
+	diag_fd = -1;
+}
+
+/*
+ * "sport == p0 || sport == p1 || ...", laid out the way ss does it: each
+ * port test falls through on a match into a JMP to the end (accept) and on
+ * a miss skips to the next test. A miss on the last test jumps 4 bytes past
+ * the end, which rejects. The kernel audits that every target is reachable
+ * through the "yes" chain, so that chain must step through every op.
+ */
+static int build_port_filter(const __u16 *lports, int nr_lports,
+			     struct inet_diag_bc_op *ops)
+{
+	int i, off, len = (nr_lports * 3 - 1) * sizeof(*ops);
+	struct inet_diag_bc_op *op = ops;
+
+	for (i = 0; i < nr_lports; i++) {
+		*op++ = (struct inet_diag_bc_op){ INET_DIAG_BC_S_EQ, 2 * sizeof(*op), 3 * sizeof(*op) };
+		*op++ = (struct inet_diag_bc_op){ 0, 0, lports[i] };
+		if (i == nr_lports - 1)
+			break;
+		off = (op - ops) * sizeof(*op);
+		*op++ = (struct inet_diag_bc_op){ INET_DIAG_BC_JMP, sizeof(*op), len - off };
+	}
+	return len;
+}
+
+static void parse_entry(struct nlmsghdr *nlh, struct sock_diag_entry *e)
+{
+	struct inet_diag_msg *msg = NLMSG_DATA(nlh);
+	int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*msg));
+	size_t addr_len = msg->idiag_family == AF_INET ? 4 : 16;
+	struct rtattr *attr;
+
+	memset(e, 0, sizeof(*e));
+	e->family = msg->idiag_family;
+	e->state = msg->idiag_state;
+	e->lport = ntohs(msg->id.idiag_sport);
+	e->dport = ntohs(msg->id.idiag_dport);
+	memcpy(&e->saddr, msg->id.idiag_src, addr_len);
+	memcpy(&e->daddr, msg->id.idiag_dst, addr_len);
+	e->rqueue = msg->idiag_rqueue;
+	e->wqueue = msg->idiag_wqueue;
+
+	for (attr = (struct rtattr *)(msg + 1); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+		struct tcp_info *info = RTA_DATA(attr);
+
+		/* older kernels send a shorter tcp_info */
+		if (attr->rta_type == INET_DIAG_INFO &&
+		    RTA_PAYLOAD(attr) >= offsetof(struct tcp_info, tcpi_snd_cwnd) +
+					 sizeof(info->tcpi_snd_cwnd))
+			e->snd_cwnd = info->tcpi_snd_cwnd;
+	}
+}
+
+static int dump_family(int family, __u32 states, const __u16 *lports, int nr_lports,
+		       struct sock_diag_entry *entries, int max_entries, int n)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct inet_diag_req_v2 req;
+		struct rtattr bc;
+		struct inet_diag_bc_op ops[MAX_FILTER_PORTS * 3];
+	} req = {};
+	struct sockaddr_nl sa = { .nl_family = AF_NETLINK };
+	char buf[32768];
+	struct nlmsghdr *nlh;
+	int bc_len = 0;
+	ssize_t len;
+
+	if (nr_lports)
+		bc_len = build_port_filter(lports, nr_lports, req.ops);
+
+	req.req.sdiag_family = family;
+	req.req.sdiag_protocol = IPPROTO_TCP;
+	req.req.idiag_states = states;
+	req.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+	req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(req.req));
+	if (bc_len) {
+		req.bc.rta_type = INET_DIAG_REQ_BYTECODE;
+		req.bc.rta_len = RTA_LENGTH(bc_len);
+		req.nlh.nlmsg_len += RTA_ALIGN(req.bc.rta_len);
+	}
+
+	if (sendto(diag_fd, &req, req.nlh.nlmsg_len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+		return -errno;
+
+	while (1) {
+		len = recv(diag_fd, buf, sizeof(buf), 0);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_DONE)
+				return n;
+			if (nlh->nlmsg_type == NLMSG_ERROR) {
+				struct nlmsgerr *err = NLMSG_DATA(nlh);
+
+				return err->error ? err->error : n;
+			}
+			/* keep draining so the next dump starts clean */
+			if (n < max_entries)
+				parse_entry(nlh, &entries[n++]);
+		}
+	}
+}
+
+static int dump_tcp(__u32 states, const __u16 *lports, int nr_lports,
+		    struct sock_diag_entry *entries, int max_entries, int n)
+{
+	if (diag_fd < 0) {
+		diag_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+		if (diag_fd < 0)
+			return -errno;
+	}
+
+	n = dump_family(AF_INET, states, lports, nr_lports, entries, max_entries, n);
+	if (n < 0)
+		goto err;
+	n = dump_family(AF_INET6, states, lports, nr_lports, entries, max_entries, n);
+	if (n < 0)
+		goto err;
+	return n;
+
+err:
+	/* a half-read dump would confuse the next request */
+	sock_diag__close();
+	return n;
+}
+
+int sock_diag__dump_tcp(const __u16 *lports, int nr_lports,
+			struct sock_diag_entry *entries, int max_entries)
+{
+	int i, batch, n = 0;
+
+	if (!nr_lports)
+		return dump_tcp(~(1U << TCP_LISTEN), NULL, 0, entries, max_entries, 0);
+
+	/* the bytecode holds MAX_FILTER_PORTS tests, larger sets take one dump per batch */
+	for (i = 0; i < nr_lports; i += batch) {
+		batch = nr_lports - i < MAX_FILTER_PORTS ? nr_lports - i : MAX_FILTER_PORTS;
+		n = dump_tcp(~(1U << TCP_LISTEN), lports + i, batch, entries, max_entries, n);
+		if (n < 0)
+			return n;
+	}
+	return n;
+}
+
+int sock_diag__dump_listen(struct sock_diag_entry *entries, int max_entries)
+{
+	return dump_tcp(1U << TCP_LISTEN, NULL, 0, entries, max_entries, 0);
+}
@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: (LGPL-2.1 OR BSD-2-Clause) */
+#ifndef __SOCK_DIAG_H
+#define __SOCK_DIAG_H
+
+#include <linux/types.h>
+
+/*
+ * A TCP socket as reported by NETLINK_SOCK_DIAG. Addresses use the same
+ * layout as struct ip_key_t, so rows can be joined on the 4-tuple.
+ */
+struct sock_diag_entry {
+	unsigned __int128 saddr;
+	unsigned __int128 daddr;
+	__u16 lport;
+	__u16 dport;
+	__u16 family;
+	__u8 state;
+	__u32 rqueue;		/* Recv-Q: bytes not yet read by the app */
+	__u32 wqueue;		/* Send-Q: bytes not yet acked by the peer */
+	__u32 snd_cwnd;		/* 0 when tcp_info is not available */
+};
+
+/*
+ * Dump the TCP sockets of both families whose local port is one of
+ * lports[], or all of them when nr_lports is 0. The filter runs in the
+ * kernel as inet_diag bytecode, one dump per batch of up to 64 ports.
+ * Returns the number of entries stored.
+ */
+int sock_diag__dump_tcp(const __u16 *lports, int nr_lports,
+			struct sock_diag_entry *entries, int max_entries);
+/* Dump the listening TCP sockets of both families. */
+int sock_diag__dump_listen(struct sock_diag_entry *entries, int max_entries);
+const char *sock_diag__state_name(int state);
+void sock_diag__close(void);
+
+#endif /* __SOCK_DIAG_H */
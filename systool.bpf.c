@@ -5,17 +5,72 @@
 #include <bpf/bpf_endian.h>
 #include "systool.h"
 #include "stat.h"
+#include "bits.bpf.h"
 
 /* Taken from kernel include/linux/socket.h. */
 #define AF_INET		2	/* Internet IP Protocol 	*/
 #define AF_INET6	10	/* IP version 6			*/
+#define ETH_P_IP	0x0800
+/* Taken from kernel include/linux/errno.h. */
+#define EIOCBQUEUED	529
 #define MAX_ENTRIES	10240
 
+/* Taken from kernel include/uapi/asm-generic/fcntl.h and arch overrides. */
+#if defined(__TARGET_ARCH_arm64)
+#define O_DIRECT	0200000
+#elif defined(__TARGET_ARCH_powerpc)
+#define O_DIRECT	0400000
+#elif defined(__TARGET_ARCH_mips)
+#define O_DIRECT	0100000
+#else
+#define O_DIRECT	040000
+#endif
+
 const volatile bool filter_cg = false;
 const volatile int target_family = -1;
 const volatile pid_t target_pid = 0;
 const volatile bool regular_file_only = true;
+const volatile bool io_size_hist = false;
 static struct file_stat zero_value = {};
+static struct hist zero_hist = {};
+static struct conn_life_t zero_life = {};
+static struct listen_stat_t zero_listen = {};
+static struct unix_stat_t zero_unix = {};
+static struct fsync_stat zero_fsync = {};
+static struct resp_stat_t zero_resp = {};
+
+/* first range checked per direction, accounted once when the call returns */
+struct io_mech_io {
+	struct file *file;
+	loff_t pos;
+	__u64 count;
+	bool has_pos;
+};
+
+struct io_mech_mark {
+	__u32 mech;
+	__u32 depth;
+	__u64 sp;
+	struct io_mech_io io[2];	/* READ, WRITE */
+};
+
+struct conn_birth {
+	__u64 ts;
+	struct conn_life_key_t key;
+	char comm[TASK_COMM_LEN];
+	bool established;
+};
+
+struct sock_owner {
+	__u32 pid;
+	char comm[TASK_COMM_LEN];
+};
+
+struct fsync_start {
+	__u64 ts;
+	struct file *file;
+	int datasync;
+};
 
 struct {
 	__uint(type, BPF_MAP_TYPE_CGROUP_ARRAY);
@@ -31,6 +86,105 @@ struct {
 	__type(value, struct traffic_t);
 } ip_map SEC(".maps");
 
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 10240);
+	__type(key, struct ip_key_t);
+	__type(value, struct traffic_t);
+} udp_map SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 10240);
+	__type(key, u64);
+	__type(value, struct tcp_conn_t);
+} tcp_conns SEC(".maps");
+
+/* Process last seen sending or receiving on an inet socket. */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u64);
+	__type(value, struct sock_owner);
+} sock_owners SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 10240);
+	__type(key, struct drop_key_t);
+	__type(value, u64);
+} drops SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 10240);
+	__type(key, struct unix_key_t);
+	__type(value, struct unix_stat_t);
+} unix_map SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 1024);
+	__type(key, struct listen_key_t);
+	__type(value, struct listen_stat_t);
+} listen_stats SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u64);
+	__type(value, struct conn_birth);
+} conn_births SEC(".maps");
+
+/*
+ * Local ports with a listener. Seeded from a sock_diag dump at startup and
+ * kept current by inet_csk_listen_start(); only sockets on these ports are
+ * timed as servers.
+ */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u16);
+	__type(value, u8);
+} listen_ports SEC(".maps");
+
+/* Time of the first unanswered read per server socket. */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u64);
+	__type(value, u64);
+} resp_starts SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct listen_key_t);
+	__type(value, struct resp_stat_t);
+} resp_times SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct conn_life_key_t);
+	__type(value, struct conn_life_t);
+} conn_lives SEC(".maps");
+
+/* Softirqs do not nest on a CPU, so one start time per CPU is enough. */
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, u32);
+	__type(value, u64);
+} softirq_starts SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, SOFTIRQ_VECS);
+	__type(key, u32);
+	__type(value, struct softirq_stat_t);
+} softirq_times SEC(".maps");
+
 struct {
 	__uint(type, BPF_MAP_TYPE_HASH);
 	__uint(max_entries, MAX_ENTRIES);
@@ -38,6 +192,58 @@ struct {
 	__type(value, struct file_stat);
 } entries SEC(".maps");
 
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u32);
+	__type(value, struct io_mech_mark);
+} io_mechs SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, u32);
+	__type(value, struct fsync_start);
+} fsync_starts SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct file_id);
+	__type(value, struct fsync_stat);
+} fsync_entries SEC(".maps");
+
+/* log2 I/O size histograms, same keys as entries, filled only with --hist */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct file_id);
+	__type(value, struct hist);
+} io_hists SEC(".maps");
+
+/*
+ * End offset of the last I/O per (file, thread). Unlike entries it is not
+ * drained every interval, so streams crossing an interval stay sequential.
+ */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct file_id);
+	__type(value, u64);
+} last_pos SEC(".maps");
+
+/*
+ * Bytes written per inode since its last fsync, keyed by file_id with
+ * pid and tid left zero. Drained by vfs_fsync_range to estimate how much
+ * data each flush had to write back.
+ */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, MAX_ENTRIES);
+	__type(key, struct file_id);
+	__type(value, u64);
+} dirty_bytes SEC(".maps");
+
 static void get_file_path(struct file *file, char *buf, size_t size)
 {
 	struct qstr dname;
@@ -66,7 +272,77 @@ static void get_file_dir(struct file *file, char *buf, size_t size) {
     bpf_probe_read_kernel(buf, size, parent_dname.name);
 }
 
-static int probe_entry(struct pt_regs *ctx, struct file *file, size_t count, enum op op)
+static void get_inode_id(struct inode *inode, struct file_id *key)
+{
+	key->dev = BPF_CORE_READ(inode, i_sb, s_dev);
+	key->rdev = BPF_CORE_READ(inode, i_rdev);
+	key->inode = BPF_CORE_READ(inode, i_ino);
+}
+
+static void get_file_id(struct file *file, struct file_id *key)
+{
+	get_inode_id(BPF_CORE_READ(file, f_inode), key);
+}
+
+static void add_dirty_bytes(struct file *file, size_t count)
+{
+	struct file_id key = {};
+	u64 bytes = count, *bytesp;
+
+	get_file_id(file, &key);
+	bytesp = bpf_map_lookup_elem(&dirty_bytes, &key);
+	if (bytesp) {
+		__sync_fetch_and_add(bytesp, bytes);
+		return;
+	}
+	bpf_map_update_elem(&dirty_bytes, &key, &bytes, BPF_NOEXIST);
+}
+
+static void classify_access(struct file_id *key, struct file_stat *valuep,
+			    const loff_t *posp, size_t count)
+{
+	loff_t pos;
+	u64 end, *lastp;
+
+	/* stream files have no position */
+	if (!posp)
+		return;
+
+	pos = *posp;
+	end = pos + count;
+	lastp = bpf_map_lookup_elem(&last_pos, key);
+	if (!lastp) {
+		bpf_map_update_elem(&last_pos, key, &end, BPF_ANY);
+		return;
+	}
+	if (*lastp == pos)
+		valuep->seq_ios++;
+	else
+		valuep->rand_ios++;
+	*lastp = end;
+}
+
+static void add_io_size(struct file_id *key, size_t count)
+{
+	struct hist *histp;
+	u64 slot;
+
+	histp = bpf_map_lookup_elem(&io_hists, key);
+	if (!histp) {
+		bpf_map_update_elem(&io_hists, key, &zero_hist, BPF_NOEXIST);
+		histp = bpf_map_lookup_elem(&io_hists, key);
+		if (!histp)
+			return;
+	}
+	slot = log2l(count);
+	if (slot >= MAX_SLOTS)
+		slot = MAX_SLOTS - 1;
+	__sync_fetch_and_add(&histp->slots[slot], 1);
+}
+
+/* posp points at a position already read from the kernel, NULL for streams */
+static int account_io(struct file *file, const loff_t *posp, size_t count,
+		      enum op op, enum io_mech mech)
 {
 	__u64 pid_tgid = bpf_get_current_pid_tgid();
 	__u32 pid = pid_tgid >> 32;
@@ -79,12 +355,10 @@ static int probe_entry(struct pt_regs *ctx, struct file *file, size_t count, enu
 		return 0;
 
 	mode = BPF_CORE_READ(file, f_inode, i_mode);
-	if (regular_file_only && !S_ISREG(mode))
+	if (regular_file_only && !S_ISREG(mode) && !S_ISFIFO(mode))
 		return 0;
 
-	key.dev = BPF_CORE_READ(file, f_inode, i_sb, s_dev);
-	key.rdev = BPF_CORE_READ(file, f_inode, i_rdev);
-	key.inode = BPF_CORE_READ(file, f_inode, i_ino);
+	get_file_id(file, &key);
 	key.pid = pid;
 	key.tid = tid;
 	valuep = bpf_map_lookup_elem(&entries, &key);
@@ -100,67 +374,316 @@ static int probe_entry(struct pt_regs *ctx, struct file *file, size_t count, enu
 		get_file_dir(file, valuep->dir, sizeof(valuep->dir));
 		if (S_ISREG(mode)) {
 			valuep->type = 'R';
+		} else if (S_ISFIFO(mode)) {
+			valuep->type = 'P';
 		} else if (S_ISSOCK(mode)) {
 			valuep->type = 'S';
 		} else {
 			valuep->type = 'O';
 		}
 	}
+	valuep->last_op = op;
+	valuep->mechs |= 1 << mech;
+	classify_access(&key, valuep, posp, count);
+	if (io_size_hist)
+		add_io_size(&key, count);
 	if (op == READ) {
 		valuep->reads++;
 		valuep->read_bytes += count;
+		if (BPF_CORE_READ(file, f_flags) & O_DIRECT)
+			valuep->direct_read_bytes += count;
 	} else {	/* op == WRITE */
 		valuep->writes++;
 		valuep->write_bytes += count;
+		if (S_ISREG(mode))
+			add_dirty_bytes(file, count);
 	}
 	return 0;
 };
 
+static int probe_entry(struct pt_regs *ctx, struct file *file, const loff_t *ppos,
+		       size_t count, enum op op, enum io_mech mech)
+{
+	loff_t pos;
+
+	if (ppos && !bpf_probe_read_kernel(&pos, sizeof(pos), ppos))
+		return account_io(file, &pos, count, op, mech);
+	return account_io(file, NULL, count, op, mech);
+}
+
 SEC("kprobe/vfs_read")
 int BPF_KPROBE(vfs_read_entry, struct file *file, char *buf, size_t count, loff_t *pos)
 {
-	return probe_entry(ctx, file, count, READ);
+	return probe_entry(ctx, file, pos, count, READ, MECH_RW);
 }
 
 SEC("kprobe/vfs_write")
 int BPF_KPROBE(vfs_write_entry, struct file *file, const char *buf, size_t count, loff_t *pos)
 {
-	return probe_entry(ctx, file, count, WRITE);
+	return probe_entry(ctx, file, pos, count, WRITE, MECH_RW);
 }
 
-static int probe_ip(bool receiving, struct sock *sk, size_t size)
+/*
+ * Every other read/write path (vectored, splice, sendfile, copy_file_range
+ * and io_uring) checks its range with rw_verify_area() before touching the
+ * file. The entry points of those paths mark the calling thread with the
+ * mechanism in use, and rw_verify_area() records the first range checked in
+ * each direction. Inner checks (splice chunks under sendfile, the splice
+ * fallback of copy_file_range, vfs_iter_write under splice) are ignored, and
+ * the outermost call accounts the bytes it returned. Plain read(2)/write(2)
+ * are not marked, so they are not counted twice.
+ */
+static int mark_io_mech(struct pt_regs *ctx, enum io_mech mech)
 {
-	struct ip_key_t ip_key = {};
-	struct traffic_t *trafficp;
-	u16 family;
-	u32 pid;
+	__u64 pid_tgid = bpf_get_current_pid_tgid();
+	__u32 tid = (__u32)pid_tgid;
+	__u64 sp = PT_REGS_SP(ctx);
+	struct io_mech_mark mark = {};
+	struct io_mech_mark *markp;
 
-	if (filter_cg && !bpf_current_task_under_cgroup(&cgroup_map, 0))
+	if (target_pid && target_pid != pid_tgid >> 32)
 		return 0;
 
-	pid = bpf_get_current_pid_tgid() >> 32;
-	if (target_pid  && target_pid != pid)
+	/*
+	 * Nested paths (e.g. sendfile over splice) keep the outer mechanism.
+	 * A call nested in the marked one runs deeper on the stack; anything
+	 * else means the mark was left behind by a missed kretprobe.
+	 */
+	markp = bpf_map_lookup_elem(&io_mechs, &tid);
+	if (markp && sp < markp->sp) {
+		markp->depth++;
 		return 0;
+	}
+	mark.mech = mech;
+	mark.depth = 1;
+	mark.sp = sp;
+	bpf_map_update_elem(&io_mechs, &tid, &mark, BPF_ANY);
+	return 0;
+}
 
-	family = BPF_CORE_READ(sk, __sk_common.skc_family);
-	if (target_family != -1 && target_family != family)
+static int unmark_io_mech(long ret)
+{
+	__u32 tid = (__u32)bpf_get_current_pid_tgid();
+	struct io_mech_mark *markp;
+	struct io_mech_io *io;
+
+	markp = bpf_map_lookup_elem(&io_mechs, &tid);
+	if (!markp)
 		return 0;
+	if (--markp->depth > 0)
+		return 0;
+	/*
+	 * io_uring completes asynchronously, so the requested length is kept
+	 * when the request was issued or queued. io_read()/io_write() return an
+	 * int; -EAGAIN means it is punted to io-wq, which checks and counts it
+	 * again, and any other error moved no data.
+	 */
+	if (markp->mech == MECH_URING && (int)ret < 0 && (int)ret != -EIOCBQUEUED)
+		goto out;
+	for (int op = READ; op <= WRITE; op++) {
+		io = &markp->io[op];
+		if (!io->file)
+			continue;
+		if (markp->mech != MECH_URING) {
+			if (ret <= 0)
+				break;
+			io->count = ret;
+		}
+		account_io(io->file, io->has_pos ? &io->pos : NULL, io->count, op,
+			   markp->mech);
+	}
+out:
+	bpf_map_delete_elem(&io_mechs, &tid);
+	return 0;
+}
 
-	/* drop */
-	if (family != AF_INET && family != AF_INET6)
+SEC("kprobe/rw_verify_area")
+int BPF_KPROBE(rw_verify_area, int read_write, struct file *file, const loff_t *ppos,
+	       size_t count)
+{
+	__u32 tid = (__u32)bpf_get_current_pid_tgid();
+	struct io_mech_mark *markp;
+	struct io_mech_io *io;
+
+	markp = bpf_map_lookup_elem(&io_mechs, &tid);
+	if (!markp)
 		return 0;
+	io = &markp->io[read_write == READ ? READ : WRITE];
+	if (io->file)
+		return 0;
+	io->file = file;
+	io->count = count;
+	io->has_pos = ppos && !bpf_probe_read_kernel(&io->pos, sizeof(io->pos), ppos);
+	return 0;
+}
 
-	ip_key.pid = pid;
-	bpf_get_current_comm(&ip_key.name, sizeof(ip_key.name));
-	ip_key.lport = BPF_CORE_READ(sk, __sk_common.skc_num);
-	ip_key.dport = bpf_ntohs(BPF_CORE_READ(sk, __sk_common.skc_dport));
-	ip_key.family = family;
+#define IO_MECH_PROBE(func, mech)			\
+SEC("kprobe/" #func)					\
+int BPF_KPROBE(func##_entry)				\
+{							\
+	return mark_io_mech(ctx, mech);			\
+}							\
+							\
+SEC("kretprobe/" #func)					\
+int BPF_KRETPROBE(func##_exit, long ret)		\
+{							\
+	return unmark_io_mech(ret);			\
+}
+
+IO_MECH_PROBE(vfs_readv, MECH_VEC)
+IO_MECH_PROBE(vfs_writev, MECH_VEC)
+IO_MECH_PROBE(vfs_iter_read, MECH_VEC)
+IO_MECH_PROBE(vfs_iter_write, MECH_VEC)
+IO_MECH_PROBE(do_splice, MECH_SPLICE)
+IO_MECH_PROBE(do_sendfile, MECH_SENDFILE)
+IO_MECH_PROBE(vfs_copy_file_range, MECH_COPY)
+IO_MECH_PROBE(io_read, MECH_URING)
+IO_MECH_PROBE(io_write, MECH_URING)
+
+/* folio fields of newer kernels: _folio_order (6.2-6.9), _flags_1 (6.10+) */
+struct folio___new {
+	unsigned long _flags_1;
+	unsigned char _folio_order;
+} __attribute__((preserve_access_index));
+
+/* Pages in a folio, as folio_nr_pages() computes it */
+static __u64 folio_pages(struct folio *folio)
+{
+	struct folio___new *f = (void *)folio;
+	struct page *tail = (void *)folio + bpf_core_type_size(struct page);
+	unsigned long flags = BPF_CORE_READ(folio, flags);
+	unsigned int order;
+
+	if (!(flags & (1UL << bpf_core_enum_value(enum pageflags, PG_head))))
+		return 1;
+	if (bpf_core_field_exists(f->_folio_order))
+		order = BPF_CORE_READ(f, _folio_order);
+	else if (bpf_core_field_exists(f->_flags_1))
+		order = BPF_CORE_READ(f, _flags_1) & 0xff;
+	else
+		order = BPF_CORE_READ(tail, compound_order);
+	return 1ULL << (order & 0x1f);
+}
 
+/*
+ * A folio inserted into the page cache while the thread's last VFS call on
+ * that file was a read is a read miss of all its pages.
+ */
+static int probe_cache_miss(struct address_space *mapping, __u64 pages)
+{
+	__u64 pid_tgid = bpf_get_current_pid_tgid();
+	struct file_id key = {};
+	struct file_stat *valuep;
+
+	get_inode_id(BPF_CORE_READ(mapping, host), &key);
+	key.pid = pid_tgid >> 32;
+	key.tid = (__u32)pid_tgid;
+	valuep = bpf_map_lookup_elem(&entries, &key);
+	if (valuep && valuep->last_op == READ)
+		__sync_fetch_and_add(&valuep->cache_misses, pages);
+	return 0;
+}
+
+SEC("kprobe/filemap_add_folio")
+int BPF_KPROBE(filemap_add_folio, struct address_space *mapping, struct folio *folio)
+{
+	return probe_cache_miss(mapping, folio_pages(folio));
+}
+
+/* Kernels before 5.16 have no folios. */
+SEC("kprobe/add_to_page_cache_lru")
+int BPF_KPROBE(add_to_page_cache_lru, struct page *page, struct address_space *mapping)
+{
+	return probe_cache_miss(mapping, 1);
+}
+
+SEC("kprobe/vfs_fsync_range")
+int BPF_KPROBE(vfs_fsync_range_entry, struct file *file, loff_t start, loff_t end, int datasync)
+{
+	__u64 pid_tgid = bpf_get_current_pid_tgid();
+	__u32 pid = pid_tgid >> 32;
+	__u32 tid = (__u32)pid_tgid;
+	struct fsync_start fs = {};
+	int mode;
+
+	if (target_pid && target_pid != pid)
+		return 0;
+
+	mode = BPF_CORE_READ(file, f_inode, i_mode);
+	if (regular_file_only && !S_ISREG(mode))
+		return 0;
+
+	fs.ts = bpf_ktime_get_ns();
+	fs.file = file;
+	fs.datasync = datasync;
+	bpf_map_update_elem(&fsync_starts, &tid, &fs, BPF_ANY);
+	return 0;
+}
+
+SEC("kretprobe/vfs_fsync_range")
+int BPF_KRETPROBE(vfs_fsync_range_exit)
+{
+	__u64 pid_tgid = bpf_get_current_pid_tgid();
+	__u32 pid = pid_tgid >> 32;
+	__u32 tid = (__u32)pid_tgid;
+	struct file_id key = {};
+	struct fsync_start *fsp;
+	struct fsync_stat *valuep;
+	struct file *file;
+	u64 delta, slot, *bytesp;
+	int datasync;
+
+	fsp = bpf_map_lookup_elem(&fsync_starts, &tid);
+	if (!fsp)
+		return 0;
+	delta = bpf_ktime_get_ns() - fsp->ts;
+	file = fsp->file;
+	datasync = fsp->datasync;
+	bpf_map_delete_elem(&fsync_starts, &tid);
+
+	get_file_id(file, &key);
+	bytesp = bpf_map_lookup_elem(&dirty_bytes, &key);
+
+	key.pid = pid;
+	key.tid = tid;
+	valuep = bpf_map_lookup_elem(&fsync_entries, &key);
+	if (!valuep) {
+		bpf_map_update_elem(&fsync_entries, &key, &zero_fsync, BPF_ANY);
+		valuep = bpf_map_lookup_elem(&fsync_entries, &key);
+		if (!valuep)
+			return 0;
+		valuep->pid = pid;
+		valuep->tid = tid;
+		bpf_get_current_comm(&valuep->comm, sizeof(valuep->comm));
+		get_file_path(file, valuep->filename, sizeof(valuep->filename));
+		get_file_dir(file, valuep->dir, sizeof(valuep->dir));
+	}
+	if (datasync)
+		valuep->fdatasyncs++;
+	else
+		valuep->fsyncs++;
+	valuep->total_ns += delta;
+	if (delta > valuep->max_ns)
+		valuep->max_ns = delta;
+	slot = log2l(delta / 1000);
+	if (slot >= MAX_SLOTS)
+		slot = MAX_SLOTS - 1;
+	valuep->slots[slot]++;
+	if (bytesp) {
+		valuep->flush_bytes += *bytesp;
+		*bytesp = 0;
+	}
+	return 0;
+}
+
+static void read_sock_addrs(struct sock *sk, u16 family, unsigned __int128 *saddr,
+			    unsigned __int128 *daddr)
+{
 	if (family == AF_INET) {
-		bpf_probe_read_kernel(&ip_key.saddr,
+		bpf_probe_read_kernel(saddr,
 				      sizeof(sk->__sk_common.skc_rcv_saddr),
 				      &sk->__sk_common.skc_rcv_saddr);
-		bpf_probe_read_kernel(&ip_key.daddr,
+		bpf_probe_read_kernel(daddr,
 				      sizeof(sk->__sk_common.skc_daddr),
 				      &sk->__sk_common.skc_daddr);
 	} else {
@@ -168,15 +691,85 @@ static int probe_ip(bool receiving, struct sock *sk, size_t size)
 		 * family == AF_INET6,
 		 * we already checked above family is correct.
 		 */
-		bpf_probe_read_kernel(&ip_key.saddr,
+		bpf_probe_read_kernel(saddr,
 				      sizeof(sk->__sk_common.skc_v6_rcv_saddr.in6_u.u6_addr32),
 				      &sk->__sk_common.skc_v6_rcv_saddr.in6_u.u6_addr32);
-		bpf_probe_read_kernel(&ip_key.daddr,
+		bpf_probe_read_kernel(daddr,
 				      sizeof(sk->__sk_common.skc_v6_daddr.in6_u.u6_addr32),
 				      &sk->__sk_common.skc_v6_daddr.in6_u.u6_addr32);
 	}
+}
+
+static struct tcp_conn_t *lookup_tcp_conn(struct sock *sk, bool create)
+{
+	u64 skaddr = (u64)sk;
+	struct tcp_conn_t conn = {};
+	struct tcp_conn_t *connp;
+
+	connp = bpf_map_lookup_elem(&tcp_conns, &skaddr);
+	if (connp || !create)
+		return connp;
+
+	conn.family = BPF_CORE_READ(sk, __sk_common.skc_family);
+	if (conn.family != AF_INET && conn.family != AF_INET6)
+		return NULL;
+	conn.lport = BPF_CORE_READ(sk, __sk_common.skc_num);
+	conn.dport = bpf_ntohs(BPF_CORE_READ(sk, __sk_common.skc_dport));
+	read_sock_addrs(sk, conn.family, &conn.saddr, &conn.daddr);
+	bpf_map_update_elem(&tcp_conns, &skaddr, &conn, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&tcp_conns, &skaddr);
+}
+
+/* Remember who uses a socket, so drops in softirq context can be attributed. */
+static void note_sock_owner(struct sock *sk, struct ip_key_t *ip_key)
+{
+	u64 skaddr = (u64)sk;
+	struct sock_owner owner = {};
+	struct sock_owner *ownerp;
+
+	ownerp = bpf_map_lookup_elem(&sock_owners, &skaddr);
+	if (ownerp && ownerp->pid == ip_key->pid)
+		return;
+	owner.pid = ip_key->pid;
+	__builtin_memcpy(owner.comm, ip_key->name, sizeof(owner.comm));
+	bpf_map_update_elem(&sock_owners, &skaddr, &owner, BPF_ANY);
+}
+
+static bool fill_ip_key(struct sock *sk, struct ip_key_t *ip_key)
+{
+	u16 family;
+	u32 pid;
+
+	if (filter_cg && !bpf_current_task_under_cgroup(&cgroup_map, 0))
+		return false;
+
+	pid = bpf_get_current_pid_tgid() >> 32;
+	if (target_pid  && target_pid != pid)
+		return false;
+
+	family = BPF_CORE_READ(sk, __sk_common.skc_family);
+	if (target_family != -1 && target_family != family)
+		return false;
+
+	/* drop */
+	if (family != AF_INET && family != AF_INET6)
+		return false;
+
+	ip_key->pid = pid;
+	bpf_get_current_comm(&ip_key->name, sizeof(ip_key->name));
+	ip_key->lport = BPF_CORE_READ(sk, __sk_common.skc_num);
+	ip_key->dport = bpf_ntohs(BPF_CORE_READ(sk, __sk_common.skc_dport));
+	ip_key->family = family;
+	read_sock_addrs(sk, family, &ip_key->saddr, &ip_key->daddr);
+	note_sock_owner(sk, ip_key);
+	return true;
+}
+
+static void add_traffic(void *map, struct ip_key_t *ip_key, bool receiving, size_t size)
+{
+	struct traffic_t *trafficp;
 
-	trafficp = bpf_map_lookup_elem(&ip_map, &ip_key);
+	trafficp = bpf_map_lookup_elem(map, ip_key);
 	if (!trafficp) {
 		struct traffic_t zero;
 
@@ -188,16 +781,79 @@ static int probe_ip(bool receiving, struct sock *sk, size_t size)
 			zero.received = 0;
 		}
 
-		bpf_map_update_elem(&ip_map, &ip_key, &zero, BPF_NOEXIST);
+		bpf_map_update_elem(map, ip_key, &zero, BPF_NOEXIST);
 	} else {
 		if (receiving)
 			trafficp->received += size;
 		else
 			trafficp->sent += size;
 
-		bpf_map_update_elem(&ip_map, &ip_key, trafficp, BPF_EXIST);
+		bpf_map_update_elem(map, ip_key, trafficp, BPF_EXIST);
 	}
+}
+
+static void add_slot(__u32 *slots, u64 val)
+{
+	u64 slot = log2l(val);
+
+	if (slot >= MAX_SLOTS)
+		slot = MAX_SLOTS - 1;
+	__sync_fetch_and_add(&slots[slot], 1);
+}
+
+/*
+ * A request starts with the first read after a response and ends with the
+ * next write, so pipelined or multi-read requests count once per turn.
+ */
+static void probe_resp_time(bool receiving, struct sock *sk, struct ip_key_t *ip_key)
+{
+	u64 skaddr = (u64)sk;
+	struct listen_key_t key = {};
+	struct resp_stat_t *statp;
+	u64 now, delta, *startp;
 
+	if (!bpf_map_lookup_elem(&listen_ports, &ip_key->lport))
+		return;
+
+	now = bpf_ktime_get_ns();
+	if (receiving) {
+		bpf_map_update_elem(&resp_starts, &skaddr, &now, BPF_NOEXIST);
+		return;
+	}
+
+	startp = bpf_map_lookup_elem(&resp_starts, &skaddr);
+	if (!startp)
+		return;
+	delta = now - *startp;
+	bpf_map_delete_elem(&resp_starts, &skaddr);
+
+	key.port = ip_key->lport;
+	key.family = ip_key->family;
+	statp = bpf_map_lookup_elem(&resp_times, &key);
+	if (!statp) {
+		bpf_map_update_elem(&resp_times, &key, &zero_resp, BPF_NOEXIST);
+		statp = bpf_map_lookup_elem(&resp_times, &key);
+		if (!statp)
+			return;
+	}
+	__sync_fetch_and_add(&statp->requests, 1);
+	__sync_fetch_and_add(&statp->total_ns, delta);
+	if (delta > statp->max_ns)
+		statp->max_ns = delta;
+	add_slot(statp->slots, delta / 1000);
+}
+
+static int probe_ip(bool receiving, struct sock *sk, size_t size)
+{
+	struct ip_key_t ip_key = {};
+
+	if (!fill_ip_key(sk, &ip_key))
+		return 0;
+	add_traffic(&ip_map, &ip_key, receiving, size);
+	probe_resp_time(receiving, sk, &ip_key);
+
+	/* start sampling RTT and retransmits for sockets that move data */
+	lookup_tcp_conn(sk, true);
 	return 0;
 }
 
@@ -222,4 +878,469 @@ int BPF_KPROBE(tcp_cleanup_rbuf, struct sock *sk, int copied)
 	return probe_ip(true, sk, copied);
 }
 
+static u32 unix_peer_pid(struct sock *sk)
+{
+	struct pid *peer_pid = BPF_CORE_READ(sk, sk_peer_pid);
+	u32 nr = 0;
+
+	/* set by connect() on stream sockets only */
+	if (peer_pid)
+		bpf_core_read(&nr, sizeof(nr), &peer_pid->numbers[0].nr);
+	return nr;
+}
+
+/* The bound path of our end, or of the peer (the server socket) if unbound. */
+static void unix_sock_path(struct sock *sk, char *path)
+{
+	struct unix_sock *usk = (struct unix_sock *)sk;
+	struct unix_address *addr;
+	int len;
+
+	addr = BPF_CORE_READ(usk, addr);
+	if (!addr)
+		addr = BPF_CORE_READ((struct unix_sock *)BPF_CORE_READ(usk, peer), addr);
+	if (!addr)
+		return;
+
+	len = BPF_CORE_READ(addr, len) - (int)sizeof(sa_family_t);
+	if (len <= 0)
+		return;
+	if (len > UNIX_PATH_LEN - 1)
+		len = UNIX_PATH_LEN - 1;
+	bpf_probe_read_kernel(path, len, addr->name[0].sun_path);
+}
+
+static int probe_unix(struct socket *sock, size_t size, bool stream)
+{
+	struct sock *sk = BPF_CORE_READ(sock, sk);
+	struct unix_key_t key = {};
+	struct unix_stat_t *statp;
+
+	if (filter_cg && !bpf_current_task_under_cgroup(&cgroup_map, 0))
+		return 0;
+
+	key.pid = bpf_get_current_pid_tgid() >> 32;
+	key.peer_pid = unix_peer_pid(sk);
+	key.stream = stream;
+	if (target_pid && target_pid != key.pid && target_pid != key.peer_pid)
+		return 0;
+
+	statp = bpf_map_lookup_elem(&unix_map, &key);
+	if (!statp) {
+		bpf_map_update_elem(&unix_map, &key, &zero_unix, BPF_NOEXIST);
+		statp = bpf_map_lookup_elem(&unix_map, &key);
+		if (!statp)
+			return 0;
+		bpf_get_current_comm(&statp->comm, sizeof(statp->comm));
+		unix_sock_path(sk, statp->path);
+	}
+	__sync_fetch_and_add(&statp->sends, 1);
+	__sync_fetch_and_add(&statp->sent, size);
+	return 0;
+}
+
+/* Receive side is derived in user space from the peer's sends. */
+SEC("kprobe/unix_stream_sendmsg")
+int BPF_KPROBE(unix_stream_sendmsg, struct socket *sock, struct msghdr *msg, size_t len)
+{
+	return probe_unix(sock, len, true);
+}
+
+/* also covers SOCK_SEQPACKET */
+SEC("kprobe/unix_dgram_sendmsg")
+int BPF_KPROBE(unix_dgram_sendmsg, struct socket *sock, struct msghdr *msg, size_t len)
+{
+	return probe_unix(sock, len, false);
+}
+
+/*
+ * Unconnected UDP sockets have no peer in the sock: senders name it in
+ * msg_name (already copied to kernel memory), receivers find it in the
+ * packet headers.
+ */
+SEC("kprobe/udp_sendmsg")
+int BPF_KPROBE(udp_sendmsg, struct sock *sk, struct msghdr *msg, size_t len)
+{
+	struct ip_key_t ip_key = {};
+	struct sockaddr_in *sin;
+
+	/* udpv6_sendmsg passes v4-mapped destinations on, already counted there */
+	if (BPF_CORE_READ(sk, __sk_common.skc_family) == AF_INET6)
+		return 0;
+	if (!fill_ip_key(sk, &ip_key))
+		return 0;
+	sin = BPF_CORE_READ(msg, msg_name);
+	if (!ip_key.dport && sin) {
+		ip_key.dport = bpf_ntohs(BPF_CORE_READ(sin, sin_port));
+		bpf_probe_read_kernel(&ip_key.daddr, sizeof(sin->sin_addr), &sin->sin_addr);
+	}
+	add_traffic(&udp_map, &ip_key, false, len);
+	return 0;
+}
+
+SEC("kprobe/udpv6_sendmsg")
+int BPF_KPROBE(udpv6_sendmsg, struct sock *sk, struct msghdr *msg, size_t len)
+{
+	struct ip_key_t ip_key = {};
+	struct sockaddr_in6 *sin6;
+
+	if (!fill_ip_key(sk, &ip_key))
+		return 0;
+	sin6 = BPF_CORE_READ(msg, msg_name);
+	if (!ip_key.dport && sin6) {
+		ip_key.dport = bpf_ntohs(BPF_CORE_READ(sin6, sin6_port));
+		bpf_probe_read_kernel(&ip_key.daddr, sizeof(sin6->sin6_addr), &sin6->sin6_addr);
+	}
+	add_traffic(&udp_map, &ip_key, false, len);
+	return 0;
+}
+
+/* udp_recvmsg() and udpv6_recvmsg() hand the copied length to skb_consume_udp(). */
+SEC("kprobe/skb_consume_udp")
+int BPF_KPROBE(skb_consume_udp, struct sock *sk, struct sk_buff *skb, int len)
+{
+	struct ip_key_t ip_key = {};
+	unsigned char *head;
+	u16 nhoff, thoff;
+	__be16 sport;
+
+	/* negative when peeking */
+	if (len <= 0 || !fill_ip_key(sk, &ip_key))
+		return 0;
+
+	if (!ip_key.dport) {
+		head = BPF_CORE_READ(skb, head);
+		nhoff = BPF_CORE_READ(skb, network_header);
+		thoff = BPF_CORE_READ(skb, transport_header);
+		bpf_probe_read_kernel(&sport, sizeof(sport),
+				      head + thoff + offsetof(struct udphdr, source));
+		ip_key.dport = bpf_ntohs(sport);
+		if (BPF_CORE_READ(skb, protocol) == bpf_htons(ETH_P_IP)) {
+			__u8 *daddr = (__u8 *)&ip_key.daddr;
+
+			/* IPv4 packets on a dual-stack socket use v4-mapped addresses */
+			if (ip_key.family == AF_INET6) {
+				daddr[10] = 0xff;
+				daddr[11] = 0xff;
+				daddr += 12;
+			}
+			bpf_probe_read_kernel(daddr, 4,
+					      head + nhoff + offsetof(struct iphdr, saddr));
+		} else {
+			bpf_probe_read_kernel(&ip_key.daddr, 16,
+					      head + nhoff + offsetof(struct ipv6hdr, saddr));
+		}
+	}
+	add_traffic(&udp_map, &ip_key, true, len);
+	return 0;
+}
+
+/*
+ * Every dropped packet, including those dropped in NET_RX softirq before
+ * reaching a socket. Not filtered by target pid.
+ */
+SEC("tracepoint/skb/kfree_skb")
+int kfree_skb(struct trace_event_raw_kfree_skb *ctx)
+{
+	struct sk_buff *skb = ctx->skbaddr;
+	struct drop_key_t key = {};
+	struct sock_owner *ownerp;
+	struct net_device *dev;
+	struct sock *sk;
+	u64 skaddr, one = 1, *countp;
+
+	if (bpf_core_field_exists(ctx->reason))
+		key.reason = ctx->reason;
+	key.protocol = bpf_ntohs(ctx->protocol);
+
+	dev = BPF_CORE_READ(skb, dev);
+	if (dev)
+		key.ifindex = BPF_CORE_READ(dev, ifindex);
+	else
+		key.ifindex = BPF_CORE_READ(skb, skb_iif);
+
+	sk = BPF_CORE_READ(skb, sk);
+	if (sk) {
+		key.lport = BPF_CORE_READ(sk, __sk_common.skc_num);
+		skaddr = (u64)sk;
+		ownerp = bpf_map_lookup_elem(&sock_owners, &skaddr);
+		if (ownerp) {
+			key.pid = ownerp->pid;
+			__builtin_memcpy(key.comm, ownerp->comm, sizeof(key.comm));
+		}
+	}
+
+	countp = bpf_map_lookup_elem(&drops, &key);
+	if (countp)
+		__sync_fetch_and_add(countp, 1);
+	else
+		bpf_map_update_elem(&drops, &key, &one, BPF_NOEXIST);
+	return 0;
+}
+
+/*
+ * Retransmits run in softirq/timer context, so they cannot be filtered by
+ * pid. With a target pid only sockets already seen in probe_ip count.
+ */
+SEC("tracepoint/tcp/tcp_retransmit_skb")
+int tcp_retransmit_skb(struct trace_event_raw_tcp_event_sk_skb *ctx)
+{
+	struct sock *sk = (struct sock *)ctx->skaddr;
+	struct tcp_conn_t *connp;
+
+	connp = lookup_tcp_conn(sk, !target_pid);
+	if (connp)
+		__sync_fetch_and_add(&connp->retrans, 1);
+	return 0;
+}
+
+/* Sample srtt and cwnd on every established-state segment received. */
+SEC("kprobe/tcp_rcv_established")
+int BPF_KPROBE(tcp_rcv_established, struct sock *sk)
+{
+	struct tcp_sock *tp = (struct tcp_sock *)sk;
+	struct tcp_conn_t *connp;
+	u32 srtt_us;
+
+	connp = lookup_tcp_conn(sk, false);
+	if (!connp)
+		return 0;
+
+	srtt_us = BPF_CORE_READ(tp, srtt_us) >> 3;
+	connp->srtt_us = srtt_us;
+	connp->snd_cwnd = BPF_CORE_READ(tp, snd_cwnd);
+	connp->srtt_us_sum += srtt_us;
+	connp->rtt_samples++;
+	return 0;
+}
+
+static struct listen_stat_t *lookup_listen_stat(struct sock *sk)
+{
+	struct listen_key_t key = {};
+	struct listen_stat_t *statp;
+	u32 backlog, max_backlog;
+
+	key.port = BPF_CORE_READ(sk, __sk_common.skc_num);
+	key.family = BPF_CORE_READ(sk, __sk_common.skc_family);
+	statp = bpf_map_lookup_elem(&listen_stats, &key);
+	if (!statp) {
+		bpf_map_update_elem(&listen_stats, &key, &zero_listen, BPF_NOEXIST);
+		statp = bpf_map_lookup_elem(&listen_stats, &key);
+		if (!statp)
+			return NULL;
+	}
+
+	backlog = BPF_CORE_READ(sk, sk_ack_backlog);
+	max_backlog = BPF_CORE_READ(sk, sk_max_ack_backlog);
+	statp->backlog = backlog;
+	statp->max_backlog = max_backlog;
+	if (backlog > statp->peak_backlog)
+		statp->peak_backlog = backlog;
+	return statp;
+}
+
+/*
+ * Listener queues are checked the way the kernel does: the accept queue
+ * is full when sk_ack_backlog > sk_max_ack_backlog, the SYN queue when
+ * its length reaches sk_max_ack_backlog. Both run in softirq context and
+ * cover every listener regardless of the target pid.
+ */
+SEC("kprobe/tcp_conn_request")
+int BPF_KPROBE(tcp_conn_request, void *rsk_ops, void *af_ops, struct sock *sk)
+{
+	struct inet_connection_sock *icsk = (struct inet_connection_sock *)sk;
+	struct listen_stat_t *statp;
+	u32 qlen;
+
+	statp = lookup_listen_stat(sk);
+	if (!statp)
+		return 0;
+
+	__sync_fetch_and_add(&statp->syns, 1);
+	if (statp->backlog > statp->max_backlog) {
+		__sync_fetch_and_add(&statp->syn_drops, 1);
+		return 0;
+	}
+	qlen = BPF_CORE_READ(icsk, icsk_accept_queue.qlen.counter);
+	if (qlen >= statp->max_backlog)
+		__sync_fetch_and_add(&statp->syn_queue_full, 1);
+	return 0;
+}
+
+static int probe_syn_recv_sock(struct sock *sk)
+{
+	struct listen_stat_t *statp;
+
+	statp = lookup_listen_stat(sk);
+	if (statp && statp->backlog > statp->max_backlog)
+		__sync_fetch_and_add(&statp->accept_overflows, 1);
+	return 0;
+}
+
+SEC("kprobe/tcp_v4_syn_recv_sock")
+int BPF_KPROBE(tcp_v4_syn_recv_sock, struct sock *sk)
+{
+	return probe_syn_recv_sock(sk);
+}
+
+SEC("kprobe/tcp_v6_syn_recv_sock")
+int BPF_KPROBE(tcp_v6_syn_recv_sock, struct sock *sk)
+{
+	return probe_syn_recv_sock(sk);
+}
+
+static struct conn_life_t *lookup_conn_life(struct conn_birth *birth)
+{
+	struct conn_life_t *lifep;
+
+	lifep = bpf_map_lookup_elem(&conn_lives, &birth->key);
+	if (lifep)
+		return lifep;
+	bpf_map_update_elem(&conn_lives, &birth->key, &zero_life, BPF_NOEXIST);
+	lifep = bpf_map_lookup_elem(&conn_lives, &birth->key);
+	if (lifep)
+		__builtin_memcpy(lifep->comm, birth->comm, sizeof(lifep->comm));
+	return lifep;
+}
+
+SEC("kprobe/inet_csk_listen_start")
+int BPF_KPROBE(inet_csk_listen_start, struct sock *sk)
+{
+	u16 port = BPF_CORE_READ(sk, __sk_common.skc_num);
+	u8 one = 1;
+
+	/* a listener without a bound port is autobound inside this call */
+	if (port)
+		bpf_map_update_elem(&listen_ports, &port, &one, BPF_ANY);
+	return 0;
+}
+
+/*
+ * Passive opens complete in softirq context and cannot be attributed to
+ * a process, so they are tracked whatever the target pid is.
+ */
+SEC("tracepoint/sock/inet_sock_set_state")
+int inet_sock_set_state(struct trace_event_raw_inet_sock_set_state *ctx)
+{
+	u64 skaddr = (u64)ctx->skaddr;
+	int oldstate = ctx->oldstate;
+	int newstate = ctx->newstate;
+	struct conn_birth birth = {};
+	struct conn_birth *birthp;
+	struct conn_life_t *lifep;
+	u64 now, delta;
+	u32 pid;
+
+	if (ctx->protocol != IPPROTO_TCP)
+		return 0;
+
+	/* a request left unanswered must not be matched by a socket reusing sk */
+	if (newstate == TCP_CLOSE)
+		bpf_map_delete_elem(&resp_starts, &skaddr);
+
+	now = bpf_ktime_get_ns();
+	if (newstate == TCP_SYN_SENT) {
+		pid = bpf_get_current_pid_tgid() >> 32;
+		if (target_pid && target_pid != pid)
+			return 0;
+		birth.ts = now;
+		birth.key.pid = pid;
+		birth.key.port = ctx->dport;
+		birth.key.active = 1;
+		bpf_get_current_comm(&birth.comm, sizeof(birth.comm));
+		bpf_map_update_elem(&conn_births, &skaddr, &birth, BPF_ANY);
+		return 0;
+	}
+	if (newstate == TCP_SYN_RECV) {
+		birth.ts = now;
+		birth.key.port = ctx->sport;
+		bpf_map_update_elem(&conn_births, &skaddr, &birth, BPF_ANY);
+		return 0;
+	}
+
+	birthp = bpf_map_lookup_elem(&conn_births, &skaddr);
+	if (!birthp)
+		return 0;
+	lifep = lookup_conn_life(birthp);
+	if (!lifep)
+		return 0;
+
+	delta = now - birthp->ts;
+	if (newstate == TCP_ESTABLISHED) {
+		if (oldstate == TCP_SYN_SENT) {
+			__sync_fetch_and_add(&lifep->connects, 1);
+			__sync_fetch_and_add(&lifep->connect_ns, delta);
+			add_slot(lifep->connect_slots, delta / 1000);
+		} else if (oldstate == TCP_SYN_RECV) {
+			__sync_fetch_and_add(&lifep->accepts, 1);
+		}
+		birthp->ts = now;
+		birthp->established = true;
+		return 0;
+	}
+	if (newstate != TCP_CLOSE)
+		return 0;
+
+	if (birthp->established) {
+		__sync_fetch_and_add(&lifep->closes, 1);
+		add_slot(lifep->duration_slots, delta / 1000000);
+	}
+	bpf_map_delete_elem(&conn_births, &skaddr);
+	return 0;
+}
+
+/*
+ * tcp_time_wait() hands the socket to a timewait sock before closing it.
+ * Only TIME_WAIT is counted: RST aborts never get here, and a FIN_WAIT2
+ * timewait sock (orphan waiting for the peer's FIN) is passed TCP_FIN_WAIT2.
+ */
+SEC("kprobe/tcp_time_wait")
+int BPF_KPROBE(tcp_time_wait, struct sock *sk, int state)
+{
+	u64 skaddr = (u64)sk;
+	struct conn_birth *birthp;
+	struct conn_life_t *lifep;
+
+	if (state != TCP_TIME_WAIT)
+		return 0;
+	birthp = bpf_map_lookup_elem(&conn_births, &skaddr);
+	if (!birthp)
+		return 0;
+	lifep = lookup_conn_life(birthp);
+	if (lifep)
+		__sync_fetch_and_add(&lifep->time_waits, 1);
+	return 0;
+}
+
+SEC("tracepoint/irq/softirq_entry")
+int softirq_entry(struct trace_event_raw_softirq *ctx)
+{
+	u64 ts = bpf_ktime_get_ns();
+	u32 key = 0;
+
+	bpf_map_update_elem(&softirq_starts, &key, &ts, BPF_ANY);
+	return 0;
+}
+
+SEC("tracepoint/irq/softirq_exit")
+int softirq_exit(struct trace_event_raw_softirq *ctx)
+{
+	struct softirq_stat_t *statp;
+	u32 key = 0, vec = ctx->vec;
+	u64 *tsp;
+
+	if (vec >= SOFTIRQ_VECS)
+		return 0;
+	tsp = bpf_map_lookup_elem(&softirq_starts, &key);
+	if (!tsp || !*tsp)
+		return 0;
+	statp = bpf_map_lookup_elem(&softirq_times, &vec);
+	if (!statp)
+		return 0;
+	statp->count++;
+	statp->total_ns += bpf_ktime_get_ns() - *tsp;
+	*tsp = 0;
+	return 0;
+}
+
 char LICENSE[] SEC("license") = "Dual BSD/GPL";
@@ -8,19 +8,24 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <net/if.h>
 #include <time.h>
 #include <unistd.h>
 
 #include <bpf/libbpf.h>
 #include <bpf/bpf.h>
+#include <bpf/btf.h>
 #include "systool.h"
 #include "systool.skel.h"
 #include "btf_helpers.h"
 #include "trace_helpers.h"
 #include "proc.h"
+#include "proc_file.h"
+#include "sock_diag.h"
 
 #define warn(...) fprintf(stderr, __VA_ARGS__)
 #define OUTPUT_ROWS_LIMIT 10240
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
 
 #define IPV4 0
 #define PORT_LENGTH 5
@@ -38,6 +43,16 @@ enum TYPE{
     TYPE_MYSQL,
 };
 
+enum TCP_GROUP {
+	GROUP_NONE,
+	GROUP_REMOTE,
+	GROUP_SUBNET,
+	GROUP_LPORT,
+	GROUP_PROCESS,
+};
+
+#define OPT_TCP_GROUP	1000
+
 struct info_t {
 	struct ip_key_t key;
 	struct traffic_t value;
@@ -46,6 +61,7 @@ struct info_t {
 static volatile sig_atomic_t exiting = 0;
 
 static pid_t target_pid = 0;
+static char *cgroupspath;
 static bool clear_screen = true;
 static bool regular_file_only = true;
 static int output_rows = 20;
@@ -53,6 +69,11 @@ static int interval = 1;
 static int count = 99999999;
 static bool verbose = false;
 static int type = TYPE_ALL;
+static long page_size;
+static bool show_hist = false;
+static int tcp_group = GROUP_NONE;
+static int tcp_group_prefix;
+static struct timespec attach_ts;
 
 const char argp_program_doc[] =
 "Trace file reads/writes by process.\n"
@@ -67,8 +88,12 @@ const char argp_program_doc[] =
 static const struct argp_option opts[] = {
 	{ "pid", 'p', "PID", 0, "Process ID to trace", 0 },
 	{ "noclear", 'C', NULL, 0, "Don't clear the screen", 0 },
+	{ "cgroup", 'c', "PATH", 0, "Show cgroup v2 CPU/memory/IO stats of PATH", 0 },
     { "type", 't', "TYPE", 0, "Type of pid to trace", 0 },
+	{ "hist", 'H', NULL, 0, "Print I/O size and TCP connection histograms", 0 },
 	{ "verbose", 'v', NULL, 0, "Verbose debug output", 0 },
+	{ "tcp-group", OPT_TCP_GROUP, "GROUP", 0,
+	  "Aggregate TCP rows by remote|subnet/<n>|lport|process", 0 },
 	{ NULL, 'h', NULL, OPTION_HIDDEN, "Show the full help", 0 },
 	{},
 };
@@ -91,9 +116,35 @@ static error_t parse_arg(int key, char *arg, struct argp_state *state)
 	case 'C':
 		clear_screen = false;
 		break;
+	case 'c':
+		cgroupspath = arg;
+		break;
 	case 'v':
 		verbose = true;
 		break;
+	case 'H':
+		show_hist = true;
+		break;
+	case OPT_TCP_GROUP:
+		if (!strcmp(arg, "remote")) {
+			tcp_group = GROUP_REMOTE;
+		} else if (!strcmp(arg, "lport")) {
+			tcp_group = GROUP_LPORT;
+		} else if (!strcmp(arg, "process")) {
+			tcp_group = GROUP_PROCESS;
+		} else if (!strncmp(arg, "subnet/", 7)) {
+			errno = 0;
+			tcp_group_prefix = strtol(arg + 7, NULL, 10);
+			if (errno || tcp_group_prefix <= 0 || tcp_group_prefix > 128) {
+				warn("invalid subnet prefix: %s\n", arg);
+				argp_usage(state);
+			}
+			tcp_group = GROUP_SUBNET;
+		} else {
+			warn("invalid TCP group: %s\n", arg);
+			argp_usage(state);
+		}
+		break;
     case 't':
         if (!strcmp(arg, "mysql")) {
             type = TYPE_MYSQL;
@@ -149,20 +200,229 @@ static char* get_file_type(char* filename){
     }
 }
 
+/* Delete every key of a map once its values have been printed. */
+static int clear_map(int fd, size_t key_size)
+{
+	char key[key_size], *prev_key = NULL;
+	int err;
+
+	while (1) {
+		err = bpf_map_get_next_key(fd, prev_key, key);
+		if (err) {
+			if (errno == ENOENT)
+				return 0;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_delete_elem(fd, key);
+		if (err) {
+			warn("bpf_map_delete_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = key;
+	}
+}
+
+/*
+ * Upper bound of the log2 bucket holding the pct-th percentile, in the
+ * unit the histogram was recorded in.
+ */
+static unsigned long long hist_percentile(const unsigned int *slots, int nr_slots,
+					  double pct)
+{
+	unsigned long long total = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < nr_slots; i++)
+		total += slots[i];
+	if (!total)
+		return 0;
+
+	for (i = 0; i < nr_slots; i++) {
+		sum += slots[i];
+		if (sum * 100.0 >= total * pct)
+			break;
+	}
+	if (i == nr_slots)
+		i--;
+	return (1ULL << (i + 1)) - 1;
+}
+
+/* Share of read bytes served from the page cache, -1 if nothing was read. */
+static double cache_hit_ratio(unsigned long long read_bytes, unsigned long long misses)
+{
+	double ratio;
+
+	if (!read_bytes)
+		return -1;
+	ratio = 100.0 - 100.0 * misses * page_size / read_bytes;
+	return ratio < 0 ? 0 : ratio;
+}
+
+/* Share of classified calls that continued where the previous one ended. */
+static double seq_ratio(unsigned long long seq_ios, unsigned long long rand_ios)
+{
+	if (!seq_ios && !rand_ios)
+		return -1;
+	return 100.0 * seq_ios / (seq_ios + rand_ios);
+}
+
+/*
+ * Seconds since *last, the previous read of a map that is cleared or diffed
+ * on each read; the first read counts from attach. Print cycles can run late, so
+ * rates use this rather than the nominal interval.
+ */
+static double map_elapsed(struct timespec *last)
+{
+	const struct timespec *from = last->tv_sec ? last : &attach_ts;
+	struct timespec now;
+	double elapsed;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (now.tv_sec - from->tv_sec) + (now.tv_nsec - from->tv_nsec) / 1e9;
+	*last = now;
+	return elapsed > 0 ? elapsed : interval;
+}
+
+static const char *fmt_ratio(char *buf, size_t size, double ratio)
+{
+	if (ratio < 0)
+		snprintf(buf, size, "-");
+	else
+		snprintf(buf, size, "%.1f", ratio);
+	return buf;
+}
+
+struct cache_proc {
+	__u32 pid;
+	char comm[TASK_COMM_LEN];
+	unsigned long long read_bytes;
+	unsigned long long cache_misses;
+};
+
+/* Only buffered reads can hit or miss the page cache. */
+static unsigned long long cached_read_bytes(const struct file_stat *v)
+{
+	return v->read_bytes - v->direct_read_bytes;
+}
+
+static void print_cache_by_pid(struct file_stat *values, int rows)
+{
+	static struct cache_proc procs[OUTPUT_ROWS_LIMIT];
+	int i, j, nr_procs = 0;
+	char ratio[16];
+
+	for (i = 0; i < rows; i++) {
+		/* only regular files go through the page cache */
+		if (!values[i].reads || values[i].type != 'R')
+			continue;
+		for (j = 0; j < nr_procs; j++) {
+			if (procs[j].pid == values[i].pid)
+				break;
+		}
+		if (j == nr_procs) {
+			procs[j].pid = values[i].pid;
+			memcpy(procs[j].comm, values[i].comm, sizeof(procs[j].comm));
+			procs[j].read_bytes = 0;
+			procs[j].cache_misses = 0;
+			nr_procs++;
+		}
+		procs[j].read_bytes += cached_read_bytes(&values[i]);
+		procs[j].cache_misses += values[i].cache_misses;
+	}
+	if (!nr_procs)
+		return;
+
+	printf("\n[Page Cache]\n");
+	printf("%-7s %-16s %-9s %-9s %-5s\n", "PID", "COMM", "R_Kb", "MISS_Kb", "HIT%");
+	nr_procs = nr_procs < output_rows ? nr_procs : output_rows;
+	for (i = 0; i < nr_procs; i++) {
+		printf("%-7d %-16s %-9lld %-9lld %-5s\n", procs[i].pid, procs[i].comm,
+		       procs[i].read_bytes / 1024,
+		       procs[i].cache_misses * page_size / 1024,
+		       fmt_ratio(ratio, sizeof(ratio),
+				 cache_hit_ratio(procs[i].read_bytes, procs[i].cache_misses)));
+	}
+}
+
+/* One letter per enum io_mech: read/write, vectored, splice, sendfile, copy, io_uring */
+static const char *fmt_mechs(char *buf, __u8 mechs)
+{
+	static const char letters[MECH_MAX] = "rvsfcu";
+	int i, n = 0;
+
+	for (i = 0; i < MECH_MAX; i++) {
+		if (mechs & (1 << i))
+			buf[n++] = letters[i];
+	}
+	buf[n] = '\0';
+	return buf;
+}
+
+struct hist_proc {
+	__u32 pid;
+	char comm[TASK_COMM_LEN];
+	struct hist hist;
+};
+
+static int print_io_size_hists(struct systool_bpf *obj, struct file_id *keys,
+			       struct file_stat *values, int rows, int total)
+{
+	static struct hist_proc procs[OUTPUT_ROWS_LIMIT];
+	int fd = bpf_map__fd(obj->maps.io_hists);
+	int i, j, k, nr_procs = 0;
+	struct hist hist;
+
+	printf("\n[IO Size]\n");
+	for (i = 0; i < total; i++) {
+		if (bpf_map_lookup_elem(fd, &keys[i], &hist))
+			continue;
+		if (i < rows) {
+			printf("TID %d COMM %s FILE %s/%s\n", values[i].tid,
+			       values[i].comm, values[i].dir, values[i].filename);
+			print_log2_hist(hist.slots, MAX_SLOTS, "bytes");
+		}
+		for (j = 0; j < nr_procs; j++) {
+			if (procs[j].pid == values[i].pid)
+				break;
+		}
+		if (j == nr_procs) {
+			memset(&procs[j], 0, sizeof(procs[j]));
+			procs[j].pid = values[i].pid;
+			memcpy(procs[j].comm, values[i].comm, sizeof(procs[j].comm));
+			nr_procs++;
+		}
+		for (k = 0; k < MAX_SLOTS; k++)
+			procs[j].hist.slots[k] += hist.slots[k];
+	}
+
+	nr_procs = nr_procs < output_rows ? nr_procs : output_rows;
+	for (i = 0; i < nr_procs; i++) {
+		printf("PID %d COMM %s\n", procs[i].pid, procs[i].comm);
+		print_log2_hist(procs[i].hist.slots, MAX_SLOTS, "bytes");
+	}
+
+	return clear_map(fd, sizeof(struct file_id));
+}
+
 static int print_iostat(struct systool_bpf *obj)
 {
 	struct file_id key, *prev_key = NULL;
+	static struct file_id keys[OUTPUT_ROWS_LIMIT];
 	static struct file_stat values[OUTPUT_ROWS_LIMIT];
-	int i, err = 0, rows = 0;
+	int i, err = 0, rows = 0, total;
 	int fd = bpf_map__fd(obj->maps.entries);
+	char ratio[16], seq[16], cpu[16], mechs[MECH_MAX + 1];
+	unsigned long long calls;
+	double avg_kb;
 
 	printf("\n[IO]\n");
 	if(type == TYPE_MYSQL){
-		printf("%-7s %-16s %-6s %-6s %-7s %-7s %1s %-20s %-20s %-20s\n",
-	       "TID", "COMM", "READS", "WRITES", "R_Kb", "W_Kb", "T", "FILE","DIR","FILETYPE");
+		printf("%-7s %-16s %-5s %-6s %-6s %-7s %-7s %-5s %-5s %-6s %1s %-6s %-20s %-20s %-20s\n",
+	       "TID", "COMM", "CPU%", "READS", "WRITES", "R_Kb", "W_Kb", "HIT%", "SEQ%", "AVG_Kb", "T", "MECH", "FILE","DIR","FILETYPE");
 	}else{
-		printf("%-7s %-16s %-6s %-6s %-7s %-7s %1s %s %-20s\n",
-	       "TID", "COMM", "READS", "WRITES", "R_Kb", "W_Kb", "T", "FILE","DIR");
+		printf("%-7s %-16s %-5s %-6s %-6s %-7s %-7s %-5s %-5s %-6s %1s %-6s %s %-20s\n",
+	       "TID", "COMM", "CPU%", "READS", "WRITES", "R_Kb", "W_Kb", "HIT%", "SEQ%", "AVG_Kb", "T", "MECH", "FILE","DIR");
 	}
 	
 
@@ -176,6 +436,7 @@ static int print_iostat(struct systool_bpf *obj)
 			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
 			return err;
 		}
+		keys[rows] = key;
 		err = bpf_map_lookup_elem(fd, &key, &values[rows++]);
 		if (err) {
 			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
@@ -184,27 +445,98 @@ static int print_iostat(struct systool_bpf *obj)
 		prev_key = &key;
 	}
 
+	total = rows;
 	rows = rows < output_rows ? rows : output_rows;
 	for (i = 0; i < rows; i++){
+		/* anonymous pipes have no dentry name */
+		if (values[i].type == 'P' && !values[i].filename[0])
+			snprintf(values[i].filename, sizeof(values[i].filename),
+				 "pipe:[%llu]", keys[i].inode);
+		fmt_ratio(ratio, sizeof(ratio), values[i].type != 'R' ? -1 :
+			  cache_hit_ratio(cached_read_bytes(&values[i]), values[i].cache_misses));
+		fmt_ratio(seq, sizeof(seq),
+			  seq_ratio(values[i].seq_ios, values[i].rand_ios));
+		/* only threads of the target pid are sampled from /proc */
+		fmt_ratio(cpu, sizeof(cpu), get_thread_cpu_usage(values[i].tid));
+		fmt_mechs(mechs, values[i].mechs);
+		calls = values[i].reads + values[i].writes;
+		avg_kb = calls ? (values[i].read_bytes + values[i].write_bytes) / 1024.0 / calls : 0;
 		if(type == TYPE_MYSQL){
-			printf("%-7d %-16s %-6lld %-6lld %-7lld %-7lld %c %-20s %-20s %-20s\n",
-		       values[i].tid, values[i].comm, values[i].reads, values[i].writes,
-		       values[i].read_bytes / 1024, values[i].write_bytes / 1024,
-		       values[i].type, values[i].filename,values[i].dir, get_file_type(values[i].filename));
+			printf("%-7d %-16s %-5s %-6lld %-6lld %-7lld %-7lld %-5s %-5s %-6.1f %c %-6s %-20s %-20s %-20s\n",
+		       values[i].tid, values[i].comm, cpu, values[i].reads, values[i].writes,
+		       values[i].read_bytes / 1024, values[i].write_bytes / 1024, ratio, seq, avg_kb,
+		       values[i].type, mechs, values[i].filename,values[i].dir, get_file_type(values[i].filename));
 		}
 		else{
-			printf("%-7d %-16s %-6lld %-6lld %-7lld %-7lld %c %-20s %-20s\n",
-		       values[i].tid, values[i].comm, values[i].reads, values[i].writes,
-		       values[i].read_bytes / 1024, values[i].write_bytes / 1024,
-		       values[i].type, values[i].filename,values[i].dir);
+			printf("%-7d %-16s %-5s %-6lld %-6lld %-7lld %-7lld %-5s %-5s %-6.1f %c %-6s %-20s %-20s\n",
+		       values[i].tid, values[i].comm, cpu, values[i].reads, values[i].writes,
+		       values[i].read_bytes / 1024, values[i].write_bytes / 1024, ratio, seq, avg_kb,
+		       values[i].type, mechs, values[i].filename,values[i].dir);
 		}
 	}
-		
+	print_cache_by_pid(values, total);
+	if (show_hist) {
+		err = print_io_size_hists(obj, keys, values, rows, total);
+		if (err)
+			return err;
+	}
 
 	printf("\n");
-	prev_key = NULL;
+	return clear_map(fd, sizeof(key));
+}
 
-	while (1) {
+struct fsync_type {
+	const char *name;
+	unsigned long long calls;
+	unsigned long long total_ns;
+	unsigned long long flush_bytes;
+	unsigned int slots[MAX_SLOTS];
+};
+
+static void print_fsync_types(struct fsync_stat *values, int rows)
+{
+	struct fsync_type types[16] = {};
+	struct fsync_type *t;
+	int i, j, nr_types = 0;
+	const char *name;
+
+	for (i = 0; i < rows; i++) {
+		name = get_file_type(values[i].filename);
+		for (j = 0; j < nr_types; j++) {
+			if (!strcmp(types[j].name, name))
+				break;
+		}
+		if (j == nr_types) {
+			if (nr_types == ARRAY_SIZE(types))
+				continue;
+			types[nr_types++].name = name;
+		}
+		t = &types[j];
+		t->calls += values[i].fsyncs + values[i].fdatasyncs;
+		t->total_ns += values[i].total_ns;
+		t->flush_bytes += values[i].flush_bytes;
+		for (j = 0; j < MAX_SLOTS; j++)
+			t->slots[j] += values[i].slots[j];
+	}
+
+	for (i = 0; i < nr_types; i++) {
+		t = &types[i];
+		printf("%-20s fsync p99 = %.3f ms, avg = %.3f ms, calls = %llu, flushed = %llu KB\n",
+		       t->name, hist_percentile(t->slots, MAX_SLOTS, 99) / 1000.0,
+		       t->total_ns / 1000000.0 / t->calls, t->calls,
+		       t->flush_bytes / 1024);
+	}
+}
+
+static int print_fsyncstat(struct systool_bpf *obj)
+{
+	struct file_id key, *prev_key = NULL;
+	static struct fsync_stat values[OUTPUT_ROWS_LIMIT];
+	int i, err = 0, rows = 0;
+	int fd = bpf_map__fd(obj->maps.fsync_entries);
+	unsigned long long calls;
+
+	while (rows < OUTPUT_ROWS_LIMIT) {
 		err = bpf_map_get_next_key(fd, prev_key, &key);
 		if (err) {
 			if (errno == ENOENT) {
@@ -214,39 +546,307 @@ static int print_iostat(struct systool_bpf *obj)
 			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
 			return err;
 		}
-		err = bpf_map_delete_elem(fd, &key);
+		err = bpf_map_lookup_elem(fd, &key, &values[rows++]);
 		if (err) {
-			warn("bpf_map_delete_elem failed: %s\n", strerror(errno));
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
 			return err;
 		}
 		prev_key = &key;
 	}
-	return err;
+
+	printf("\n[FSYNC]\n");
+	if (type == TYPE_MYSQL)
+		print_fsync_types(values, rows);
+	printf("%-7s %-16s %-6s %-6s %-8s %-8s %-8s %-8s %-20s %-20s\n",
+	       "TID", "COMM", "FSYNC", "FDSYNC", "FLUSH_Kb", "AVG_us", "P99_us",
+	       "MAX_us", "FILE", "DIR");
+
+	rows = rows < output_rows ? rows : output_rows;
+	for (i = 0; i < rows; i++) {
+		calls = values[i].fsyncs + values[i].fdatasyncs;
+		printf("%-7d %-16s %-6lld %-6lld %-8lld %-8lld %-8lld %-8lld %-20s %-20s\n",
+		       values[i].tid, values[i].comm, values[i].fsyncs,
+		       values[i].fdatasyncs, values[i].flush_bytes / 1024,
+		       calls ? values[i].total_ns / 1000 / calls : 0,
+		       hist_percentile(values[i].slots, MAX_SLOTS, 99),
+		       values[i].max_ns / 1000, values[i].filename, values[i].dir);
+	}
+
+	printf("\n");
+	return clear_map(fd, sizeof(key));
 }
 
-static int print_tcpstat(struct systool_bpf *obj)
+static int load_tcp_conns(struct systool_bpf *obj, struct tcp_conn_t *conns, int *nr_conns)
 {
-	char buf[256];
-	struct ip_key_t key, *prev_key = NULL;
-	static struct info_t infos[OUTPUT_ROWS_LIMIT];
-	int i, err = 0;
-	int fd = bpf_map__fd(obj->maps.ip_map);
-	int rows = 0;
-	bool ipv6_header_printed = false;
-	int pid_max_fd = open("/proc/sys/kernel/pid_max", O_RDONLY);
-	int pid_maxlen = read(pid_max_fd, buf, sizeof buf) - 1;
+	int fd = bpf_map__fd(obj->maps.tcp_conns);
+	__u64 key, *prev_key = NULL;
+	int err, n = 0;
 
-	if (pid_maxlen < 6)
-		pid_maxlen = 6;
-	close(pid_max_fd);
+	while (n < OUTPUT_ROWS_LIMIT) {
+		err = bpf_map_get_next_key(fd, prev_key, &key);
+		if (err) {
+			if (errno == ENOENT)
+				break;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_lookup_elem(fd, &key, &conns[n]);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = &key;
+		n++;
+	}
+	*nr_conns = n;
+	return 0;
+}
 
-	while (1) {
+static struct tcp_conn_t *find_tcp_conn(struct tcp_conn_t *conns, int nr_conns,
+					struct ip_key_t *key)
+{
+	int i;
+
+	for (i = 0; i < nr_conns; i++) {
+		if (conns[i].family == key->family && conns[i].lport == key->lport &&
+		    conns[i].dport == key->dport && conns[i].saddr == key->saddr &&
+		    conns[i].daddr == key->daddr)
+			return &conns[i];
+	}
+	return NULL;
+}
+
+/* Order on the 4-tuple, diags are sorted once so each row is a bsearch */
+static int sock_diag_cmp(const void *a, const void *b)
+{
+	const struct sock_diag_entry *x = a, *y = b;
+
+	if (x->family != y->family)
+		return x->family < y->family ? -1 : 1;
+	if (x->lport != y->lport)
+		return x->lport < y->lport ? -1 : 1;
+	if (x->dport != y->dport)
+		return x->dport < y->dport ? -1 : 1;
+	if (x->saddr != y->saddr)
+		return x->saddr < y->saddr ? -1 : 1;
+	if (x->daddr != y->daddr)
+		return x->daddr < y->daddr ? -1 : 1;
+	return 0;
+}
+
+static struct sock_diag_entry *find_sock_diag(struct sock_diag_entry *diags, int nr_diags,
+					       struct ip_key_t *key)
+{
+	struct sock_diag_entry target = {
+		.saddr = key->saddr,
+		.daddr = key->daddr,
+		.lport = key->lport,
+		.dport = key->dport,
+		.family = key->family,
+	};
+
+	return bsearch(&target, diags, nr_diags, sizeof(*diags), sock_diag_cmp);
+}
+
+/* Current queues, state and cwnd come from sock_diag, the rest from BPF. */
+static void fmt_tcp_conn(char *buf, size_t size, struct tcp_conn_t *conn,
+			 struct sock_diag_entry *diag)
+{
+	char retrans[16] = "-", srtt[16] = "-", cwnd[16] = "-";
+
+	if (conn) {
+		snprintf(retrans, sizeof(retrans), "%llu", conn->retrans);
+		if (conn->rtt_samples) {
+			snprintf(srtt, sizeof(srtt), "%.2f",
+				 conn->srtt_us_sum / 1000.0 / conn->rtt_samples);
+			snprintf(cwnd, sizeof(cwnd), "%u", conn->snd_cwnd);
+		}
+	}
+	if (diag && diag->snd_cwnd)
+		snprintf(cwnd, sizeof(cwnd), "%u", diag->snd_cwnd);
+
+	if (!diag) {
+		snprintf(buf, size, "%7s %7s %5s %7s %7s %-10s", retrans, srtt, cwnd,
+			 "-", "-", "-");
+		return;
+	}
+	snprintf(buf, size, "%7s %7s %5s %7u %7u %-10s", retrans, srtt, cwnd,
+		 diag->rqueue, diag->wqueue, sock_diag__state_name(diag->state));
+}
+
+struct unix_info_t {
+	struct unix_key_t key;
+	struct unix_stat_t value;
+};
+
+static int print_unixstat(struct systool_bpf *obj)
+{
+	static struct unix_info_t infos[OUTPUT_ROWS_LIMIT];
+	struct unix_key_t *prev_key = NULL, rkey;
+	int fd = bpf_map__fd(obj->maps.unix_map);
+	char peer[16], path[UNIX_PATH_LEN + 1];
+	unsigned long long received;
+	int i, j, err, rows = 0, total;
+
+	while (rows < OUTPUT_ROWS_LIMIT) {
 		err = bpf_map_get_next_key(fd, prev_key, &infos[rows].key);
 		if (err) {
-			if (errno == ENOENT) {
-				err = 0;
+			if (errno == ENOENT)
 				break;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_lookup_elem(fd, &infos[rows].key, &infos[rows].value);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = &infos[rows].key;
+		rows++;
+	}
+
+	printf("\n[UNIX]\n");
+	printf("%-7s %-16s %-7s %-6s %8s %8s %8s %s\n",
+	       "PID", "COMM", "PEER", "TYPE", "SENDS", "TX_KB", "RX_KB", "PATH");
+
+	total = rows;
+	rows = rows < output_rows ? rows : output_rows;
+	for (i = 0; i < rows; i++) {
+		struct unix_key_t *key = &infos[i].key;
+		struct unix_stat_t *value = &infos[i].value;
+
+		/* what the peer sent to us on the same kind of socket */
+		received = 0;
+		if (key->peer_pid) {
+			rkey.pid = key->peer_pid;
+			rkey.peer_pid = key->pid;
+			rkey.stream = key->stream;
+			for (j = 0; j < total; j++) {
+				if (!memcmp(&infos[j].key, &rkey, sizeof(rkey))) {
+					received = infos[j].value.sent;
+					break;
+				}
 			}
+			snprintf(peer, sizeof(peer), "%d", key->peer_pid);
+		} else {
+			snprintf(peer, sizeof(peer), "-");
+		}
+
+		/* abstract names start with a NUL byte */
+		if (!value->path[0] && value->path[1])
+			snprintf(path, sizeof(path), "@%s", value->path + 1);
+		else
+			snprintf(path, sizeof(path), "%s", value->path);
+
+		printf("%-7d %-16s %-7s %-6s %8llu %8llu %8llu %s\n",
+		       key->pid, value->comm, peer, key->stream ? "stream" : "dgram",
+		       value->sends, value->sent / 1024, received / 1024, path);
+	}
+
+	return clear_map(fd, sizeof(struct unix_key_t));
+}
+
+#define LISTEN_SATURATED_PCT	80
+
+/* Per-port listen queue saturation, printed under the somaxconn line. */
+static int print_listen_stats(struct systool_bpf *obj, int somaxconn)
+{
+	struct listen_key_t key, *prev_key = NULL;
+	struct listen_stat_t stat;
+	int fd = bpf_map__fd(obj->maps.listen_stats);
+	bool header_printed = false;
+	double sat;
+	int err;
+
+	while (1) {
+		err = bpf_map_get_next_key(fd, prev_key, &key);
+		if (err) {
+			if (errno == ENOENT)
+				break;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_lookup_elem(fd, &key, &stat);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = &key;
+
+		if (!header_printed) {
+			printf("%-6s %-4s %8s %8s %8s %6s %8s %9s %10s %8s\n",
+			       "LPORT", "FAM", "BACKLOG", "PEAK", "MAX", "SAT%",
+			       "SYNS", "SYN_DROP", "SYNQ_FULL", "ACC_OVF");
+			header_printed = true;
+		}
+		sat = stat.max_backlog ? 100.0 * stat.peak_backlog / stat.max_backlog : 0;
+		printf("%-6d %-4s %8u %8u %8u %6.1f %8llu %9llu %10llu %8llu%s%s\n",
+		       key.port, key.family == AF_INET6 ? "v6" : "v4",
+		       stat.backlog, stat.peak_backlog, stat.max_backlog, sat,
+		       stat.syns, stat.syn_drops, stat.syn_queue_full,
+		       stat.accept_overflows,
+		       sat >= LISTEN_SATURATED_PCT || stat.syn_drops || stat.accept_overflows ?
+		       "  <- saturated" : "",
+		       (int)stat.max_backlog == somaxconn ? " (capped by somaxconn)" : "");
+	}
+
+	return clear_map(fd, sizeof(key));
+}
+
+static int print_resp_times(struct systool_bpf *obj)
+{
+	struct listen_key_t key, *prev_key = NULL;
+	struct resp_stat_t stat;
+	int fd = bpf_map__fd(obj->maps.resp_times);
+	static struct timespec last_read;
+	double elapsed = map_elapsed(&last_read);
+	bool header_printed = false;
+	int err;
+
+	while (1) {
+		err = bpf_map_get_next_key(fd, prev_key, &key);
+		if (err) {
+			if (errno == ENOENT)
+				break;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_lookup_elem(fd, &key, &stat);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = &key;
+
+		if (!header_printed) {
+			printf("%-6s %-4s %8s %11s %11s %11s %11s\n", "LPORT", "FAM", "REQ/s",
+			       "RESP_AVG_ms", "RESP_P50_ms", "RESP_P99_ms", "RESP_MAX_ms");
+			header_printed = true;
+		}
+		printf("%-6d %-4s %8.1f %11.3f %11.3f %11.3f %11.3f\n",
+		       key.port, key.family == AF_INET6 ? "v6" : "v4",
+		       stat.requests / elapsed,
+		       stat.requests ? stat.total_ns / 1000000.0 / stat.requests : 0,
+		       hist_percentile(stat.slots, MAX_SLOTS, 50) / 1000.0,
+		       hist_percentile(stat.slots, MAX_SLOTS, 99) / 1000.0,
+		       stat.max_ns / 1000000.0);
+		if (show_hist)
+			print_log2_hist(stat.slots, MAX_SLOTS, "response usecs");
+	}
+
+	return clear_map(fd, sizeof(key));
+}
+
+static int load_ip_map(int fd, struct info_t *infos, int *nr_rows)
+{
+	struct ip_key_t *prev_key = NULL;
+	int err, rows = 0;
+
+	while (rows < OUTPUT_ROWS_LIMIT) {
+		err = bpf_map_get_next_key(fd, prev_key, &infos[rows].key);
+		if (err) {
+			if (errno == ENOENT)
+				break;
 			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
 			return err;
 		}
@@ -258,11 +858,46 @@ static int print_tcpstat(struct systool_bpf *obj)
 		prev_key = &infos[rows].key;
 		rows++;
 	}
-	printf("\n[TCP]\n");
-	print_tcp_backlog();
-	printf("%-*s %-12s %-21s %-21s %6s %6s\n",
-				 pid_maxlen, "PID", "COMM", "LADDR", "RADDR",
-				 "RX_KB", "TX_KB");
+	*nr_rows = rows;
+	return 0;
+}
+
+static int get_pid_maxlen(void)
+{
+	static struct proc_file pid_max_file = PROC_FILE_INIT;
+	const char *buf;
+	int pid_maxlen = 0;
+
+	if (!proc_file__is_open(&pid_max_file))
+		proc_file__open(&pid_max_file, "/proc/sys/kernel/pid_max");
+	buf = proc_file__read(&pid_max_file);
+	if (buf)
+		pid_maxlen = strcspn(buf, "\n");
+	if (pid_maxlen < 6)
+		pid_maxlen = 6;
+	return pid_maxlen;
+}
+
+static void print_ip_header(int pid_maxlen, int width, const char *laddr,
+			    const char *raddr, bool tcp)
+{
+	printf("%-*s %-12s %-*s %-*s %6s %6s", pid_maxlen, "PID", "COMM",
+	       width, laddr, width, raddr, "RX_KB", "TX_KB");
+	if (tcp)
+		printf(" %7s %7s %5s %7s %7s %-10s", "RETRANS", "SRTT_ms", "CWND",
+		       "RECV_Q", "SEND_Q", "STATE");
+	printf("\n");
+}
+
+/* Rows of ip_map or udp_map; conns and diags add the TCP health columns. */
+static void print_ip_rows(struct info_t *infos, int rows, struct tcp_conn_t *conns,
+			  int nr_conns, struct sock_diag_entry *diags, int nr_diags)
+{
+	int i, pid_maxlen = get_pid_maxlen();
+	bool ipv6_header_printed = false;
+	char conn_buf[96] = "";
+
+	print_ip_header(pid_maxlen, 21, "LADDR", "RADDR", conns);
 
 	rows = rows < output_rows ? rows : output_rows;
 	for (i = 0; i < rows; i++) {
@@ -275,9 +910,8 @@ static int print_tcpstat(struct systool_bpf *obj)
 			/* Width to fit IPv6 plus port. */
 			column_width = 51;
 			if (!ipv6_header_printed) {
-				printf("\n%-*s %-12s %-51s %-51s %6s %6s\n",
-							pid_maxlen, "PID", "COMM", "LADDR6",
-							"RADDR6", "RX_KB", "TX_KB");
+				printf("\n");
+				print_ip_header(pid_maxlen, 51, "LADDR6", "RADDR6", conns);
 				ipv6_header_printed = true;
 			}
 		}
@@ -301,37 +935,545 @@ static int print_tcpstat(struct systool_bpf *obj)
 		snprintf(saddr_port, size, "%s:%d", saddr, key->lport);
 		snprintf(daddr_port, size, "%s:%d", daddr, key->dport);
 
-		printf("%-*d %-12.12s %-*s %-*s %6ld %6ld\n",
+		if (conns)
+			fmt_tcp_conn(conn_buf, sizeof(conn_buf),
+				     find_tcp_conn(conns, nr_conns, key),
+				     find_sock_diag(diags, nr_diags, key));
+
+		printf("%-*d %-12.12s %-*s %-*s %6ld %6ld %s\n",
 					 pid_maxlen, key->pid, key->name,
 					 column_width, saddr_port,
 					 column_width, daddr_port,
-					 value->received / 1024, value->sent / 1024);
+					 value->received / 1024, value->sent / 1024,
+					 conn_buf);
+	}
+}
+
+struct tcp_group_t {
+	char name[INET6_ADDRSTRLEN + 32];
+	struct ip_key_t *key;		/* one of the rows, for the 4-tuple */
+	unsigned long long received;
+	unsigned long long sent;
+	unsigned long long retrans;
+	int conns;
+};
+
+static void tcp_group_name(struct ip_key_t *key, char *buf, size_t size)
+{
+	unsigned char addr[16];
+	char daddr[INET6_ADDRSTRLEN];
+	int i, prefix, bits;
+
+	switch (tcp_group) {
+	case GROUP_LPORT:
+		snprintf(buf, size, "%d", key->lport);
+		return;
+	case GROUP_PROCESS:
+		snprintf(buf, size, "%d %s", key->pid, key->name);
+		return;
+	case GROUP_SUBNET:
+		bits = key->family == AF_INET ? 32 : 128;
+		prefix = tcp_group_prefix < bits ? tcp_group_prefix : bits;
+		memcpy(addr, &key->daddr, sizeof(addr));
+		for (i = 0; i < bits / 8; i++) {
+			if (prefix >= (i + 1) * 8)
+				continue;
+			addr[i] &= prefix > i * 8 ? 0xff << (8 - (prefix - i * 8)) : 0;
+		}
+		inet_ntop(key->family, addr, daddr, sizeof(daddr));
+		snprintf(buf, size, "%s/%d", daddr, prefix);
+		return;
+	default:
+		inet_ntop(key->family, &key->daddr, daddr, sizeof(daddr));
+		snprintf(buf, size, "%s", daddr);
+		return;
+	}
+}
+
+static bool same_tuple(const struct ip_key_t *x, const struct ip_key_t *y)
+{
+	return x->family == y->family && x->lport == y->lport && x->dport == y->dport &&
+	       x->saddr == y->saddr && x->daddr == y->daddr;
+}
+
+/* By name, then 4-tuple so rows of a socket shared by processes are adjacent */
+static int group_name_cmp(const void *a, const void *b)
+{
+	const struct tcp_group_t *x = a, *y = b;
+	const struct ip_key_t *kx = x->key, *ky = y->key;
+	int ret = strcmp(x->name, y->name);
+
+	if (ret)
+		return ret;
+	if (kx->family != ky->family)
+		return kx->family < ky->family ? -1 : 1;
+	if (kx->lport != ky->lport)
+		return kx->lport < ky->lport ? -1 : 1;
+	if (kx->dport != ky->dport)
+		return kx->dport < ky->dport ? -1 : 1;
+	if (kx->saddr != ky->saddr)
+		return kx->saddr < ky->saddr ? -1 : 1;
+	if (kx->daddr != ky->daddr)
+		return kx->daddr < ky->daddr ? -1 : 1;
+	return 0;
+}
+
+static int group_bytes_cmp(const void *a, const void *b)
+{
+	const struct tcp_group_t *x = a, *y = b;
+	unsigned long long bx = x->received + x->sent, by = y->received + y->sent;
+
+	return bx < by ? 1 : bx > by ? -1 : 0;
+}
+
+/* Aggregate ip_map rows by --tcp-group and print the top groups by bytes. */
+static void print_tcp_groups(struct info_t *infos, int rows, struct tcp_conn_t *conns,
+			     int nr_conns)
+{
+	static struct tcp_group_t groups[OUTPUT_ROWS_LIMIT];
+	struct ip_key_t *prev_key = NULL;
+	struct tcp_conn_t *conn;
+	int i, nr_groups = 0;
+
+	for (i = 0; i < rows; i++) {
+		tcp_group_name(&infos[i].key, groups[i].name, sizeof(groups[i].name));
+		groups[i].key = &infos[i].key;
+		groups[i].received = infos[i].value.received;
+		groups[i].sent = infos[i].value.sent;
+		conn = find_tcp_conn(conns, nr_conns, &infos[i].key);
+		groups[i].retrans = conn ? conn->retrans : 0;
+		groups[i].conns = 1;
+	}
+	qsort(groups, rows, sizeof(groups[0]), group_name_cmp);
+	for (i = 0; i < rows; i++) {
+		if (nr_groups && !strcmp(groups[nr_groups - 1].name, groups[i].name)) {
+			groups[nr_groups - 1].received += groups[i].received;
+			groups[nr_groups - 1].sent += groups[i].sent;
+			/* ip_map is per pid: a socket shared by processes is one connection */
+			if (!same_tuple(prev_key, groups[i].key)) {
+				groups[nr_groups - 1].retrans += groups[i].retrans;
+				groups[nr_groups - 1].conns++;
+			}
+			prev_key = groups[i].key;
+			continue;
+		}
+		prev_key = groups[i].key;
+		groups[nr_groups++] = groups[i];
+	}
+	qsort(groups, nr_groups, sizeof(groups[0]), group_bytes_cmp);
+
+	printf("%-45s %6s %8s %8s %7s\n", "GROUP", "CONNS", "RX_KB", "TX_KB", "RETRANS");
+	nr_groups = nr_groups < output_rows ? nr_groups : output_rows;
+	for (i = 0; i < nr_groups; i++)
+		printf("%-45s %6d %8llu %8llu %7llu\n", groups[i].name, groups[i].conns,
+		       groups[i].received / 1024, groups[i].sent / 1024, groups[i].retrans);
+}
+
+/*
+ * Ask sock_diag only for the local ports of the rows that will be shown;
+ * the 4-tuple join happens in print_ip_rows().
+ */
+static int load_sock_diags(struct info_t *infos, int rows,
+			   struct sock_diag_entry *diags, int max_diags)
+{
+	__u16 lports[OUTPUT_ROWS_LIMIT];
+	int i, j, nr_lports = 0, n;
+
+	rows = rows < output_rows ? rows : output_rows;
+	for (i = 0; i < rows; i++) {
+		for (j = 0; j < nr_lports; j++)
+			if (lports[j] == infos[i].key.lport)
+				break;
+		if (j == nr_lports)
+			lports[nr_lports++] = infos[i].key.lport;
+	}
+	if (!nr_lports)
+		return 0;
+
+	n = sock_diag__dump_tcp(lports, nr_lports, diags, max_diags);
+	if (n < 0) {
+		if (verbose)
+			warn("sock_diag dump failed: %s\n", strerror(-n));
+		return 0;
 	}
+	qsort(diags, n, sizeof(*diags), sock_diag_cmp);
+	return n;
+}
+
+/* Listeners that predate the tool; later ones come from inet_csk_listen_start */
+static void load_listen_ports(struct systool_bpf *obj)
+{
+	static struct sock_diag_entry listens[OUTPUT_ROWS_LIMIT];
+	int fd = bpf_map__fd(obj->maps.listen_ports);
+	__u8 one = 1;
+	int i, n;
+
+	n = sock_diag__dump_listen(listens, OUTPUT_ROWS_LIMIT);
+	if (n < 0) {
+		warn("sock_diag listen dump failed: %s\n", strerror(-n));
+		return;
+	}
+	for (i = 0; i < n; i++)
+		bpf_map_update_elem(fd, &listens[i].lport, &one, BPF_ANY);
+}
+
+static int print_tcpstat(struct systool_bpf *obj)
+{
+	static struct info_t infos[OUTPUT_ROWS_LIMIT];
+	static struct tcp_conn_t conns[OUTPUT_ROWS_LIMIT];
+	static struct sock_diag_entry diags[OUTPUT_ROWS_LIMIT];
+	int fd = bpf_map__fd(obj->maps.ip_map);
+	int err, rows = 0, nr_conns = 0, nr_diags;
+
+	err = load_ip_map(fd, infos, &rows);
+	if (err)
+		return err;
+	err = load_tcp_conns(obj, conns, &nr_conns);
+	if (err)
+		return err;
+
+	printf("\n[TCP]\n");
+	err = print_listen_stats(obj, print_tcp_backlog());
+	if (err)
+		return err;
+	err = print_resp_times(obj);
+	if (err)
+		return err;
+	if (tcp_group == GROUP_NONE) {
+		nr_diags = load_sock_diags(infos, rows, diags, OUTPUT_ROWS_LIMIT);
+		print_ip_rows(infos, rows, conns, nr_conns, diags, nr_diags);
+	}
+	else
+		print_tcp_groups(infos, rows, conns, nr_conns);
 
 	printf("\n");
+	err = clear_map(bpf_map__fd(obj->maps.tcp_conns), sizeof(__u64));
+	if (err)
+		return err;
+	return clear_map(fd, sizeof(struct ip_key_t));
+}
 
-	prev_key = NULL;
-	while (1) {
-		err = bpf_map_get_next_key(fd, prev_key, &key);
+static int print_udpstat(struct systool_bpf *obj)
+{
+	static struct info_t infos[OUTPUT_ROWS_LIMIT];
+	int fd = bpf_map__fd(obj->maps.udp_map);
+	int err, rows = 0;
+
+	err = load_ip_map(fd, infos, &rows);
+	if (err)
+		return err;
+
+	printf("\n[UDP]\n");
+	print_ip_rows(infos, rows, NULL, 0, NULL, 0);
+
+	printf("\n");
+	return clear_map(fd, sizeof(struct ip_key_t));
+}
+
+static struct btf *vmlinux_btf;
+
+/* Name of an skb_drop_reason value, looked up in the running kernel's BTF. */
+static const char *drop_reason_name(__u32 reason)
+{
+	static const char prefix[] = "SKB_DROP_REASON_";
+	static const struct btf_type *t;
+	static bool loaded;
+	const struct btf_enum *e;
+	const char *name;
+	int i, id;
+
+	if (!reason)
+		return "UNKNOWN";
+	if (!loaded) {
+		loaded = true;
+		vmlinux_btf = btf__load_vmlinux_btf();
+		if (vmlinux_btf) {
+			id = btf__find_by_name_kind(vmlinux_btf, "skb_drop_reason",
+						    BTF_KIND_ENUM);
+			t = id > 0 ? btf__type_by_id(vmlinux_btf, id) : NULL;
+		}
+	}
+	if (!t)
+		return "UNKNOWN";
+
+	e = btf_enum(t);
+	for (i = 0; i < btf_vlen(t); i++, e++) {
+		if ((__u32)e->val != reason)
+			continue;
+		name = btf__name_by_offset(vmlinux_btf, e->name_off);
+		if (!strncmp(name, prefix, sizeof(prefix) - 1))
+			name += sizeof(prefix) - 1;
+		return name;
+	}
+	return "UNKNOWN";
+}
+
+struct drop_info_t {
+	struct drop_key_t key;
+	__u64 count;
+};
+
+static int drop_cmp(const void *a, const void *b)
+{
+	const struct drop_info_t *x = a, *y = b;
+
+	return x->count < y->count ? 1 : x->count > y->count ? -1 : 0;
+}
+
+static const char *fmt_l3_proto(__u16 protocol)
+{
+	switch (protocol) {
+	case 0x0800:
+		return "IPv4";
+	case 0x86dd:
+		return "IPv6";
+	case 0x0806:
+		return "ARP";
+	default:
+		return "other";
+	}
+}
+
+static int print_drops(struct systool_bpf *obj)
+{
+	static struct drop_info_t infos[OUTPUT_ROWS_LIMIT];
+	struct drop_key_t *prev_key = NULL;
+	int fd = bpf_map__fd(obj->maps.drops);
+	static struct timespec last_read;
+	double elapsed = map_elapsed(&last_read);
+	char ifname[IF_NAMESIZE], port[8], pid[16];
+	int i, err, rows = 0;
+
+	while (rows < OUTPUT_ROWS_LIMIT) {
+		err = bpf_map_get_next_key(fd, prev_key, &infos[rows].key);
 		if (err) {
-			if (errno == ENOENT) {
-				err = 0;
+			if (errno == ENOENT)
 				break;
-			}
 			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
 			return err;
 		}
-		err = bpf_map_delete_elem(fd, &key);
+		err = bpf_map_lookup_elem(fd, &infos[rows].key, &infos[rows].count);
 		if (err) {
-			warn("bpf_map_delete_elem failed: %s\n", strerror(errno));
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
 			return err;
 		}
-		prev_key = &key;
+		prev_key = &infos[rows].key;
+		rows++;
+	}
+	qsort(infos, rows, sizeof(infos[0]), drop_cmp);
+
+	printf("\n[Drops]\n");
+	printf("%-32s %-16s %-5s %-6s %-7s %-16s %10s\n",
+	       "REASON", "IFACE", "PROTO", "LPORT", "PID", "COMM", "DROPS/s");
+
+	rows = rows < output_rows ? rows : output_rows;
+	for (i = 0; i < rows; i++) {
+		struct drop_key_t *key = &infos[i].key;
+
+		if (!key->ifindex || !if_indextoname(key->ifindex, ifname))
+			snprintf(ifname, sizeof(ifname), "-");
+		if (key->lport)
+			snprintf(port, sizeof(port), "%d", key->lport);
+		else
+			snprintf(port, sizeof(port), "-");
+		if (key->pid)
+			snprintf(pid, sizeof(pid), "%d", key->pid);
+		else
+			snprintf(pid, sizeof(pid), "-");
+		printf("%-32s %-16s %-5s %-6s %-7s %-16s %10.1f\n",
+		       drop_reason_name(key->reason), ifname,
+		       fmt_l3_proto(key->protocol), port, pid,
+		       key->pid ? key->comm : "-",
+		       infos[i].count / elapsed);
+	}
+
+	return clear_map(fd, sizeof(struct drop_key_t));
+}
+
+static int print_conn_lifecycle(struct systool_bpf *obj)
+{
+	struct conn_life_key_t key, *prev_key = NULL;
+	static struct conn_life_key_t keys[OUTPUT_ROWS_LIMIT];
+	static struct conn_life_t values[OUTPUT_ROWS_LIMIT];
+	int fd = bpf_map__fd(obj->maps.conn_lives);
+	static struct timespec last_read;
+	double elapsed = map_elapsed(&last_read);
+	int i, err, rows = 0;
+	char pid[16];
+
+	while (rows < OUTPUT_ROWS_LIMIT) {
+		err = bpf_map_get_next_key(fd, prev_key, &keys[rows]);
+		if (err) {
+			if (errno == ENOENT)
+				break;
+			warn("bpf_map_get_next_key failed: %s\n", strerror(errno));
+			return err;
+		}
+		err = bpf_map_lookup_elem(fd, &keys[rows], &values[rows]);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			return err;
+		}
+		prev_key = &keys[rows];
+		rows++;
+	}
+
+	printf("\n[TCP Lifecycle]\n");
+	printf("%-6s %-3s %-7s %-16s %8s %8s %8s %8s %11s %11s %11s %11s\n",
+	       "PORT", "DIR", "PID", "COMM", "CONN/s", "ACC/s", "CLOSE/s", "TW/s",
+	       "CONN_AVG_ms", "CONN_P99_ms", "DUR_P50_ms", "DUR_P99_ms");
+
+	rows = rows < output_rows ? rows : output_rows;
+	for (i = 0; i < rows; i++) {
+		struct conn_life_t *v = &values[i];
+
+		if (keys[i].active)
+			snprintf(pid, sizeof(pid), "%d", keys[i].pid);
+		else
+			snprintf(pid, sizeof(pid), "-");
+		printf("%-6d %-3s %-7s %-16s %8.1f %8.1f %8.1f %8.1f %11.3f %11.3f %11llu %11llu\n",
+		       keys[i].port, keys[i].active ? "out" : "in", pid,
+		       keys[i].active ? v->comm : "-",
+		       v->connects / elapsed, v->accepts / elapsed,
+		       v->closes / elapsed, v->time_waits / elapsed,
+		       v->connects ? v->connect_ns / 1000000.0 / v->connects : 0,
+		       hist_percentile(v->connect_slots, MAX_SLOTS, 99) / 1000.0,
+		       hist_percentile(v->duration_slots, MAX_SLOTS, 50),
+		       hist_percentile(v->duration_slots, MAX_SLOTS, 99));
+		if (!show_hist)
+			continue;
+		if (v->connects)
+			print_log2_hist(v->connect_slots, MAX_SLOTS, "connect usecs");
+		if (v->closes)
+			print_log2_hist(v->duration_slots, MAX_SLOTS, "duration msecs");
+	}
+
+	return clear_map(fd, sizeof(key));
+}
+
+#define SOFTIRQ_HOT_PCT	50
+#define SOFTIRQ_NET_RX	3
+#define SOFTIRQ_BLOCK	4
+
+static const char *softirq_names[SOFTIRQ_VECS] = {
+	"HI", "TIMER", "NET_TX", "NET_RX", "BLOCK",
+	"IRQ_POLL", "TASKLET", "SCHED", "HRTIMER", "RCU",
+};
+
+/* Share of the interval each CPU spent in each softirq vector. */
+static int print_softirqs(struct systool_bpf *obj)
+{
+	int fd = bpf_map__fd(obj->maps.softirq_times);
+	int nr_cpus = libbpf_num_possible_cpus();
+	static struct softirq_stat_t *prev;
+	struct softirq_stat_t *stats;
+	double pct[SOFTIRQ_VECS], total, hot;
+	static struct timespec last_read;
+	double elapsed_ns = map_elapsed(&last_read) * 1e9;
+	__u32 vec;
+	int i, cpu, err = 0;
+
+	if (nr_cpus < 0) {
+		warn("failed to get number of CPUs: %d\n", nr_cpus);
+		return nr_cpus;
+	}
+	if (!prev)
+		prev = calloc((size_t)nr_cpus * SOFTIRQ_VECS, sizeof(*prev));
+	stats = calloc((size_t)nr_cpus * SOFTIRQ_VECS, sizeof(*stats));
+	if (!stats || !prev) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	/*
+	 * The counters only grow; diff against the previous snapshot instead of
+	 * zeroing them, which would lose events landing between read and reset.
+	 */
+	for (vec = 0; vec < SOFTIRQ_VECS; vec++) {
+		err = bpf_map_lookup_elem(fd, &vec, &stats[vec * nr_cpus]);
+		if (err) {
+			warn("bpf_map_lookup_elem failed: %s\n", strerror(errno));
+			goto out;
+		}
+	}
+	for (i = 0; i < nr_cpus * SOFTIRQ_VECS; i++) {
+		struct softirq_stat_t cur = stats[i];
+
+		stats[i].count -= prev[i].count;
+		stats[i].total_ns -= prev[i].total_ns;
+		prev[i] = cur;
 	}
 
+	printf("\n[SoftIRQ Time]\n");
+	printf("%-4s", "CPU");
+	for (vec = 0; vec < SOFTIRQ_VECS; vec++)
+		printf(" %8s%%", softirq_names[vec]);
+	printf(" %8s%%\n", "TOTAL");
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		total = 0;
+		for (vec = 0; vec < SOFTIRQ_VECS; vec++) {
+			pct[vec] = 100.0 * stats[vec * nr_cpus + cpu].total_ns / elapsed_ns;
+			total += pct[vec];
+		}
+		if (total == 0)
+			continue;
+
+		printf("%-4d", cpu);
+		for (vec = 0; vec < SOFTIRQ_VECS; vec++)
+			printf(" %9.2f", pct[vec]);
+		printf(" %9.2f", total);
+
+		/* a single CPU drowning in packet or block completions */
+		hot = pct[SOFTIRQ_NET_RX] > pct[SOFTIRQ_BLOCK] ?
+		      pct[SOFTIRQ_NET_RX] : pct[SOFTIRQ_BLOCK];
+		if (hot >= SOFTIRQ_HOT_PCT)
+			printf("  <- %s hot", pct[SOFTIRQ_NET_RX] >= pct[SOFTIRQ_BLOCK] ?
+			       "NET_RX" : "BLOCK");
+		printf("\n");
+	}
+
+out:
+	free(stats);
 	return err;
 }
 
+static void disable_missing_probe(struct bpf_program *entry, struct bpf_program *exit,
+				  const char *func)
+{
+	if (kprobe_exists(func))
+		return;
+	bpf_program__set_autoload(entry, false);
+	bpf_program__set_autoload(exit, false);
+}
+
+/* Marker probes for I/O paths this kernel lacks (or inlined) are skipped. */
+static void set_io_mech_autoload(struct systool_bpf *obj)
+{
+	/* without it the markers below are harmless but account nothing */
+	if (!kprobe_exists("rw_verify_area"))
+		bpf_program__set_autoload(obj->progs.rw_verify_area, false);
+
+	disable_missing_probe(obj->progs.vfs_readv_entry,
+			      obj->progs.vfs_readv_exit, "vfs_readv");
+	disable_missing_probe(obj->progs.vfs_writev_entry,
+			      obj->progs.vfs_writev_exit, "vfs_writev");
+	disable_missing_probe(obj->progs.vfs_iter_read_entry,
+			      obj->progs.vfs_iter_read_exit, "vfs_iter_read");
+	disable_missing_probe(obj->progs.vfs_iter_write_entry,
+			      obj->progs.vfs_iter_write_exit, "vfs_iter_write");
+	disable_missing_probe(obj->progs.do_splice_entry,
+			      obj->progs.do_splice_exit, "do_splice");
+	disable_missing_probe(obj->progs.do_sendfile_entry,
+			      obj->progs.do_sendfile_exit, "do_sendfile");
+	disable_missing_probe(obj->progs.vfs_copy_file_range_entry,
+			      obj->progs.vfs_copy_file_range_exit, "vfs_copy_file_range");
+	disable_missing_probe(obj->progs.io_read_entry,
+			      obj->progs.io_read_exit, "io_read");
+	disable_missing_probe(obj->progs.io_write_entry,
+			      obj->progs.io_write_exit, "io_write");
+}
+
 int main(int argc, char **argv)
 {
 	LIBBPF_OPTS(bpf_object_open_opts, open_opts);
@@ -348,6 +1490,7 @@ int main(int argc, char **argv)
 		return err;
 
 	libbpf_set_print(libbpf_print_fn);
+	page_size = sysconf(_SC_PAGESIZE);
 
 	err = ensure_core_btf(&open_opts);
 	if (err) {
@@ -363,6 +1506,20 @@ int main(int argc, char **argv)
 
 	obj->rodata->target_pid = target_pid;
 	obj->rodata->regular_file_only = regular_file_only;
+	obj->rodata->io_size_hist = show_hist;
+
+	if (kprobe_exists("filemap_add_folio"))
+		bpf_program__set_autoload(obj->progs.add_to_page_cache_lru, false);
+	else
+		bpf_program__set_autoload(obj->progs.filemap_add_folio, false);
+	set_io_mech_autoload(obj);
+	/* tcp_v6_syn_recv_sock and udpv6_sendmsg live in the ipv6 module */
+	if (!kprobe_exists("tcp_v6_syn_recv_sock"))
+		bpf_program__set_autoload(obj->progs.tcp_v6_syn_recv_sock, false);
+	if (!kprobe_exists("udpv6_sendmsg"))
+		bpf_program__set_autoload(obj->progs.udpv6_sendmsg, false);
+	if (!kprobe_exists("skb_consume_udp"))
+		bpf_program__set_autoload(obj->progs.skb_consume_udp, false);
 
 	err = systool_bpf__load(obj);
 	if (err) {
@@ -370,6 +1527,8 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	load_listen_ports(obj);
+
 	err = systool_bpf__attach(obj);
 	if (err) {
 		warn("failed to attach BPF programs: %d\n", err);
@@ -382,6 +1541,8 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &attach_ts);
+	init_proc_samples();
 	while (1) {
 		sleep(interval);
 
@@ -391,10 +1552,32 @@ int main(int argc, char **argv)
 				goto cleanup;
 		}
 		print_system_limits(target_pid);
+		if (cgroupspath || target_pid)
+			print_cgroup_stats(target_pid, cgroupspath);
+		err = print_softirqs(obj);
+		if (err)
+			goto cleanup;
+		print_diskstats();
 		err = print_iostat(obj);
 		if (err)
 			goto cleanup;
+		err = print_fsyncstat(obj);
+		if (err)
+			goto cleanup;
+		print_net_counters();
 		err = print_tcpstat(obj);
+		if (err)
+			goto cleanup;
+		err = print_udpstat(obj);
+		if (err)
+			goto cleanup;
+		err = print_conn_lifecycle(obj);
+		if (err)
+			goto cleanup;
+		err = print_drops(obj);
+		if (err)
+			goto cleanup;
+		err = print_unixstat(obj);
 		if (err)
 			goto cleanup;
 		count--;
@@ -403,6 +1586,8 @@ int main(int argc, char **argv)
 	}
 
 cleanup:
+	sock_diag__close();
+	btf__free(vmlinux_btf);
 	systool_bpf__destroy(obj);
 	cleanup_core_btf(&open_opts);
 
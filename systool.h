@@ -4,12 +4,26 @@
 
 #define PATH_MAX	4096
 #define TASK_COMM_LEN	16
+#define MAX_SLOTS	27
+#define SOFTIRQ_VECS	10	/* NR_SOFTIRQS */
+#define UNIX_PATH_LEN	108
 
 enum op {
 	READ,
 	WRITE,
 };
 
+/* I/O path a file was accessed through, kept as a bitmask per row. */
+enum io_mech {
+	MECH_RW,	/* read(2)/write(2) */
+	MECH_VEC,	/* readv/writev, preadv2/pwritev2, vfs_iter_read/write */
+	MECH_SPLICE,	/* splice(2) */
+	MECH_SENDFILE,	/* sendfile(2) */
+	MECH_COPY,	/* copy_file_range(2) */
+	MECH_URING,	/* io_uring read/write */
+	MECH_MAX,
+};
+
 struct file_id {
 	__u64 inode;
 	__u32 dev;
@@ -23,12 +37,36 @@ struct file_stat {
 	__u64 read_bytes;
 	__u64 writes;
 	__u64 write_bytes;
+	__u64 cache_misses;	/* pages added to the page cache by reads */
+	__u64 direct_read_bytes;	/* O_DIRECT reads, which bypass the page cache */
+	__u64 seq_ios;		/* calls starting where the previous one ended */
+	__u64 rand_ios;
 	__u32 pid;
 	__u32 tid;
 	char filename[PATH_MAX];
 	char dir[PATH_MAX];
 	char comm[TASK_COMM_LEN];
 	char type;
+	__u8 last_op;
+	__u8 mechs;
+};
+
+struct hist {
+	__u32 slots[MAX_SLOTS];
+};
+
+struct fsync_stat {
+	__u64 fsyncs;
+	__u64 fdatasyncs;
+	__u64 flush_bytes;
+	__u64 total_ns;
+	__u64 max_ns;
+	__u32 slots[MAX_SLOTS];	/* log2 latency in usecs */
+	__u32 pid;
+	__u32 tid;
+	char filename[PATH_MAX];
+	char dir[PATH_MAX];
+	char comm[TASK_COMM_LEN];
 };
 
 struct ip_key_t {
@@ -46,5 +84,97 @@ struct traffic_t {
 	size_t received;
 };
 
+/* AF_UNIX traffic from pid to peer_pid (0 when the peer is unknown). */
+struct unix_key_t {
+	__u32 pid;
+	__u32 peer_pid;
+	__u32 stream;
+};
+
+struct unix_stat_t {
+	__u64 sends;
+	__u64 sent;
+	char comm[TASK_COMM_LEN];
+	char path[UNIX_PATH_LEN];	/* bound path of either end, '\0' leads abstract names */
+};
+
+/* Dropped packets per reason and interface, with the owning socket if any. */
+struct drop_key_t {
+	__u32 reason;		/* enum skb_drop_reason, 0 before 5.17 */
+	__u32 ifindex;
+	__u32 pid;		/* last process seen using the socket */
+	__u16 lport;
+	__u16 protocol;		/* ETH_P_* in host order */
+	char comm[TASK_COMM_LEN];
+};
+
+/* Per-socket TCP health, keyed by the kernel socket address. */
+struct tcp_conn_t {
+	unsigned __int128 saddr;
+	unsigned __int128 daddr;
+	__u16 lport;
+	__u16 dport;
+	__u16 family;
+	__u32 srtt_us;		/* last sampled smoothed RTT */
+	__u32 snd_cwnd;		/* last sampled congestion window */
+	__u64 srtt_us_sum;
+	__u64 rtt_samples;
+	__u64 retrans;
+};
+
+struct listen_key_t {
+	__u16 port;
+	__u16 family;
+};
+
+/* Listen queue pressure per listening socket. */
+struct listen_stat_t {
+	__u64 syns;
+	__u64 syn_drops;		/* SYN dropped, accept queue full */
+	__u64 syn_queue_full;		/* SYN queue full, dropped or cookied */
+	__u64 accept_overflows;		/* handshake done, accept queue full */
+	__u32 backlog;			/* accept queue length at last event */
+	__u32 peak_backlog;
+	__u32 max_backlog;		/* listen() backlog, capped by somaxconn */
+};
+
+/*
+ * Server response time per local port: time from the first read of a
+ * request to the first write of its response on the same socket.
+ */
+struct resp_stat_t {
+	__u64 requests;
+	__u64 total_ns;
+	__u64 max_ns;
+	__u32 slots[MAX_SLOTS];		/* log2 response time in usecs */
+};
+
+/* Softirq handler runs per vector, kept per CPU. */
+struct softirq_stat_t {
+	__u64 count;
+	__u64 total_ns;
+};
+
+/*
+ * TCP connection lifecycle per service. port is the local port for
+ * accepted connections and the remote port for outgoing ones; pid is
+ * only known for outgoing connections.
+ */
+struct conn_life_key_t {
+	__u32 pid;
+	__u16 port;
+	__u16 active;
+};
+
+struct conn_life_t {
+	__u64 connects;
+	__u64 accepts;
+	__u64 closes;
+	__u64 time_waits;			/* active closes, each leaves a TIME_WAIT */
+	__u64 connect_ns;
+	__u32 connect_slots[MAX_SLOTS];		/* log2 connect latency in usecs */
+	__u32 duration_slots[MAX_SLOTS];	/* log2 connection lifetime in msecs */
+	char comm[TASK_COMM_LEN];
+};
 
 #endif /* __SYSTOOL_H */